@@ -16,9 +16,11 @@
 // Author: Julian Kunkel
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <plugins/md-dummy.h>
+#include <plugins/md-posix-common.h>
 #include <md_util.h>
 
 #include <mpi.h>
@@ -29,6 +31,12 @@ static int print_pattern = 0;
 static FILE * outfile = NULL;
 static int rank = -1;
 
+// submitted asynchronous operations, they are executed in FIFO order by complete_op
+static md_async_op_t ** queue = NULL;
+static int queue_size = 0;
+static int queue_start = 0;
+static int queue_count = 0;
+
 static option_help options [] = {
   {'p', "print-pattern", "Prints the output pattern into pattern-<RANK>.txt", OPTION_FLAG, 'd', & print_pattern},
   {'f', "fake-errors", "Fake errors while running benchmark, best to use with --ignore-precreate-errors.", OPTION_FLAG, 'd', & fake_errors},
@@ -64,6 +72,9 @@ static int finalize(){
   if(outfile){
     fclose(outfile);
   }
+  free(queue);
+  queue = NULL;
+  queue_size = 0;
   return MD_SUCCESS;
 }
 
@@ -151,7 +162,46 @@ static int delete_obj(char * dirname, char * filename){
   return MD_SUCCESS;
 }
 
+static int submit_op(md_async_op_t * op){
+  if(queue_count == queue_size){
+    int new_size = queue_size == 0 ? 16 : queue_size * 2;
+    md_async_op_t ** new_queue = malloc(sizeof(md_async_op_t *) * new_size);
+    for(int i=0; i < queue_count; i++){
+      new_queue[i] = queue[(queue_start + i) % queue_size];
+    }
+    free(queue);
+    queue = new_queue;
+    queue_size = new_size;
+    queue_start = 0;
+  }
+  queue[(queue_start + queue_count) % queue_size] = op;
+  queue_count++;
+  return MD_SUCCESS;
+}
 
+static md_async_op_t * complete_op(){
+  if(queue_count == 0){
+    return NULL;
+  }
+  md_async_op_t * op = queue[queue_start];
+  queue_start = (queue_start + 1) % queue_size;
+  queue_count--;
+  switch(op->type){
+    case(MD_OP_WRITE):
+      op->ret = write_obj(op->dset, op->name, op->buf, op->size);
+      break;
+    case(MD_OP_READ):
+      op->ret = read_obj(op->dset, op->name, op->buf, op->size);
+      break;
+    case(MD_OP_STAT):
+      op->ret = stat_obj(op->dset, op->name, op->size);
+      break;
+    case(MD_OP_DELETE):
+      op->ret = delete_obj(op->dset, op->name);
+      break;
+  }
+  return op;
+}
 
 
 struct md_plugin md_plugin_dummy = {
@@ -170,5 +220,21 @@ struct md_plugin md_plugin_dummy = {
   write_obj,
   read_obj,
   stat_obj,
-  delete_obj
+  delete_obj,
+
+  1, // thread_safe
+
+  submit_op,
+  complete_op,
+
+  NULL, // write_objs
+  NULL, // read_objs
+  NULL, // stat_objs
+  NULL, // delete_objs
+
+  NULL, // evict_obj
+  NULL, // obj_residency
+
+  md_posix_def_subdir_name,
+  md_posix_def_subdir_obj_name
 };
@@ -0,0 +1,529 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+/*
+This plugin issues the POSIX metadata operations via io_uring.
+An object write is a single linked chain openat -> write -> close, an object read is openat -> read -> close,
+the file descriptor lives in the registered (direct) file table of the ring, i.e., it is never returned to user space.
+Stat and delete are single statx and unlinkat requests.
+The latency reported for an operation covers the whole chain.
+The ring is used directly via the system calls, liburing is not needed.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+
+#include <plugins/md-iouring.h>
+#include <plugins/md-posix-common.h>
+
+static char * dir = "out";
+static int created_root_dir = 0;
+static int ring_entries = 64;
+
+static option_help options [] = {
+  {'D', "root-dir", "Root directory", OPTION_OPTIONAL_ARGUMENT, 's', & dir},
+  {'E', "ring-entries", "Number of submission queue entries of the ring, each object operation requires up to 3 entries", OPTION_OPTIONAL_ARGUMENT, 'd', & ring_entries},
+  LAST_OPTION
+};
+
+// the kind of request inside a chain, encoded into the lower bits of the user data
+enum{
+  REQ_OPEN = 0,
+  REQ_DATA = 1,
+  REQ_CLOSE = 2,
+  REQ_SINGLE = 3
+};
+
+// one object operation in flight, the index is also the slot in the direct file table
+typedef struct chain_t{
+  md_async_op_t * op;
+  int index;
+  int remaining; // number of outstanding completions
+  int res; // the first error of the chain
+  int failed_req;
+  struct statx stx;
+  struct chain_t * next; // in the list of free chains
+} chain_t;
+
+static struct{
+  int fd;
+  unsigned * sq_head;
+  unsigned * sq_tail;
+  unsigned * sq_mask;
+  unsigned * sq_array;
+  struct io_uring_sqe * sqes;
+  unsigned * cq_head;
+  unsigned * cq_tail;
+  unsigned * cq_mask;
+  struct io_uring_cqe * cqes;
+  void * sq_ptr;
+  size_t sq_size;
+  void * cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+} ring;
+
+// number of prepared but not yet published entries
+static unsigned sq_pending = 0;
+// number of submitted entries whose completion has not been reaped
+static unsigned requests_in_flight = 0;
+
+static chain_t * chains = NULL;
+static int chain_count = 0;
+static chain_t * free_chains = NULL;
+
+// completed operations in order of completion, returned by complete_op
+static md_async_op_t ** done = NULL;
+static int done_size = 0;
+static int done_start = 0;
+static int done_count = 0;
+
+static option_help * get_options(){
+  return options;
+}
+
+static int ring_setup(){
+  struct io_uring_params p;
+  memset(& p, 0, sizeof(p));
+  ring.fd = (int) syscall(__NR_io_uring_setup, ring_entries, & p);
+  if (ring.fd < 0){
+    printf("Error setting up io_uring: %s\n", strerror(errno));
+    return MD_ERROR_UNKNOWN;
+  }
+
+  ring.sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring.cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP){
+    ring.sq_size = ring.cq_size > ring.sq_size ? ring.cq_size : ring.sq_size;
+    ring.cq_size = ring.sq_size;
+  }
+  ring.sq_ptr = mmap(NULL, ring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+  if (ring.sq_ptr == MAP_FAILED){
+    return MD_ERROR_UNKNOWN;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP){
+    ring.cq_ptr = ring.sq_ptr;
+  }else{
+    ring.cq_ptr = mmap(NULL, ring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+    if (ring.cq_ptr == MAP_FAILED){
+      return MD_ERROR_UNKNOWN;
+    }
+  }
+  ring.sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring.sqes = mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+  if (ring.sqes == MAP_FAILED){
+    return MD_ERROR_UNKNOWN;
+  }
+
+  char * sq = (char *) ring.sq_ptr;
+  ring.sq_head = (unsigned *) (sq + p.sq_off.head);
+  ring.sq_tail = (unsigned *) (sq + p.sq_off.tail);
+  ring.sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+  ring.sq_array = (unsigned *) (sq + p.sq_off.array);
+  char * cq = (char *) ring.cq_ptr;
+  ring.cq_head = (unsigned *) (cq + p.cq_off.head);
+  ring.cq_tail = (unsigned *) (cq + p.cq_off.tail);
+  ring.cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+  ring.cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+  // a chain needs up to 3 entries, each chain owns one slot of the sparse direct file table
+  chain_count = p.sq_entries / 3;
+  int * fds = malloc(sizeof(int) * chain_count);
+  for(int i=0; i < chain_count; i++){
+    fds[i] = -1;
+  }
+  int ret = (int) syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_FILES, fds, chain_count);
+  free(fds);
+  if (ret < 0){
+    printf("Error registering the io_uring file table: %s\n", strerror(errno));
+    return MD_ERROR_UNKNOWN;
+  }
+
+  chains = malloc(sizeof(chain_t) * chain_count);
+  free_chains = NULL;
+  for(int i=chain_count - 1; i >= 0; i--){
+    chains[i].index = i;
+    chains[i].next = free_chains;
+    free_chains = & chains[i];
+  }
+  return MD_SUCCESS;
+}
+
+static int initialize(){
+  if (ring_entries < 3){
+    printf("The ring needs at least 3 entries\n");
+    return MD_ERROR_UNKNOWN;
+  }
+  return ring_setup();
+}
+
+static int finalize(){
+  free(chains);
+  chains = NULL;
+  free(done);
+  done = NULL;
+  done_size = 0;
+  munmap(ring.sqes, ring.sqes_size);
+  if (ring.cq_ptr != ring.sq_ptr){
+    munmap(ring.cq_ptr, ring.cq_size);
+  }
+  munmap(ring.sq_ptr, ring.sq_size);
+  close(ring.fd);
+  return MD_SUCCESS;
+}
+
+static struct io_uring_sqe * get_sqe(chain_t * c, int req){
+  const unsigned index = (*ring.sq_tail + sq_pending) & *ring.sq_mask;
+  struct io_uring_sqe * sqe = & ring.sqes[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->user_data = (uint64_t) (uintptr_t) c | req;
+  ring.sq_array[index] = index;
+  sq_pending++;
+  requests_in_flight++;
+  c->remaining++;
+  return sqe;
+}
+
+static int ring_enter(unsigned to_submit, unsigned min_complete){
+  int ret;
+  if (to_submit > 0){
+    // publish the prepared entries
+    __atomic_store_n(ring.sq_tail, *ring.sq_tail + sq_pending, __ATOMIC_RELEASE);
+    sq_pending = 0;
+  }
+  do{
+    ret = (int) syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+  }while(ret < 0 && errno == EINTR);
+  return ret;
+}
+
+static int map_result(chain_t * c){
+  if (c->res == 0){
+    return MD_SUCCESS;
+  }
+  if (c->failed_req == REQ_OPEN){
+    return c->op->type == MD_OP_WRITE ? MD_ERROR_CREATE : MD_ERROR_FIND;
+  }
+  if (c->res == -ENOENT){
+    return MD_ERROR_FIND;
+  }
+  return MD_ERROR_UNKNOWN;
+}
+
+static void push_done(md_async_op_t * op){
+  if(done_count == done_size){
+    int new_size = done_size == 0 ? 16 : done_size * 2;
+    md_async_op_t ** new_done = malloc(sizeof(md_async_op_t *) * new_size);
+    for(int i=0; i < done_count; i++){
+      new_done[i] = done[(done_start + i) % done_size];
+    }
+    free(done);
+    done = new_done;
+    done_size = new_size;
+    done_start = 0;
+  }
+  done[(done_start + done_count) % done_size] = op;
+  done_count++;
+}
+
+static void chain_done(chain_t * c){
+  c->op->ret = map_result(c);
+  push_done(c->op);
+  c->next = free_chains;
+  free_chains = c;
+}
+
+// process all available completions, the chains of completed operations are reused immediately
+static void reap_completions(){
+  unsigned head = *ring.cq_head;
+  const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+  for(; head != tail; head++){
+    struct io_uring_cqe * cqe = & ring.cqes[head & *ring.cq_mask];
+    chain_t * c = (chain_t *) (uintptr_t) (cqe->user_data & ~ (uint64_t) 3);
+    const int req = (int) (cqe->user_data & 3);
+    int res = cqe->res;
+    if (req == REQ_DATA && res >= 0 && (size_t) res != c->op->size){
+      res = -EIO; // short read or write
+    }
+    if (req == REQ_SINGLE && res >= 0 && c->op->type == MD_OP_STAT && c->stx.stx_size != c->op->size){
+      res = -EIO; // unexpected size
+    }
+    if (res < 0 && c->res == 0){
+      c->res = res;
+      c->failed_req = req;
+    }
+    requests_in_flight--;
+    if (--c->remaining == 0){
+      chain_done(c);
+    }
+  }
+  __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Submit the prepared entries of the chain c, the entries of earlier chains have all been consumed by the kernel.
+   If the kernel is short of resources, the chain is submitted again once a completion has been reaped.
+   If the kernel consumes only a part of the chain, the link is broken and the entries not consumed are taken back:
+   if none of them has been consumed, the operation is not submitted and an error is returned,
+   otherwise it fails with an error once the consumed entries complete. */
+static int ring_submit(chain_t * c){
+  const unsigned count = sq_pending;
+  int ret;
+  while (1){
+    ret = ring_enter(count, 0);
+    if (ret >= 0 || (errno != EAGAIN && errno != EBUSY) || requests_in_flight == count){
+      break;
+    }
+    if (ring_enter(0, 1) < 0){
+      break;
+    }
+    reap_completions();
+  }
+  if (ret == (int) count){
+    return MD_SUCCESS;
+  }
+  printf("Error submitting to io_uring: %s\n", ret < 0 ? strerror(errno) : "short submission");
+  // the kernel consumes entries only within io_uring_enter, thus the remaining ones can be taken back
+  const unsigned left = ret < 0 ? count : count - (unsigned) ret;
+  const unsigned tail = *ring.sq_tail - left;
+  const struct io_uring_sqe * sqe = & ring.sqes[ring.sq_array[tail & *ring.sq_mask]];
+  __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+  requests_in_flight -= left;
+  c->remaining -= left;
+  if (left == count){
+    c->next = free_chains;
+    free_chains = c;
+    return MD_ERROR_UNKNOWN;
+  }
+  if (c->res == 0){
+    c->res = -ECANCELED;
+    c->failed_req = (int) (sqe->user_data & 3);
+  }
+  if (c->remaining == 0){
+    chain_done(c);
+  }
+  return MD_SUCCESS;
+}
+
+static int submit_op(md_async_op_t * op){
+  // if more operations are submitted than the ring can hold, wait for completions
+  while (free_chains == NULL){
+    if (ring_enter(0, 1) < 0){
+      return MD_ERROR_UNKNOWN;
+    }
+    reap_completions();
+  }
+  chain_t * c = free_chains;
+  free_chains = c->next;
+  c->op = op;
+  c->remaining = 0;
+  c->res = 0;
+  c->failed_req = REQ_SINGLE;
+
+  struct io_uring_sqe * sqe;
+  switch(op->type){
+    case(MD_OP_WRITE):
+    case(MD_OP_READ):{
+      const int is_write = op->type == MD_OP_WRITE;
+      sqe = get_sqe(c, REQ_OPEN);
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uint64_t) (uintptr_t) op->name;
+      sqe->len = 0644;
+      sqe->open_flags = is_write ? (O_CREAT | O_TRUNC | O_WRONLY) : O_RDONLY;
+      sqe->file_index = c->index + 1;
+      sqe->flags = IOSQE_IO_LINK;
+
+      sqe = get_sqe(c, REQ_DATA);
+      sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = c->index;
+      sqe->addr = (uint64_t) (uintptr_t) op->buf;
+      sqe->len = (unsigned) op->size;
+      sqe->off = 0;
+      sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+
+      sqe = get_sqe(c, REQ_CLOSE);
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->file_index = c->index + 1;
+      break;
+    }case(MD_OP_STAT):{
+      sqe = get_sqe(c, REQ_SINGLE);
+      sqe->opcode = IORING_OP_STATX;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uint64_t) (uintptr_t) op->name;
+      sqe->len = STATX_SIZE;
+      sqe->off = (uint64_t) (uintptr_t) & c->stx;
+      break;
+    }case(MD_OP_DELETE):{
+      sqe = get_sqe(c, REQ_SINGLE);
+      sqe->opcode = IORING_OP_UNLINKAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uint64_t) (uintptr_t) op->name;
+      break;
+    }default:
+      c->next = free_chains;
+      free_chains = c;
+      return MD_ERROR_UNKNOWN;
+  }
+
+  return ring_submit(c);
+}
+
+static md_async_op_t * complete_op(){
+  while(done_count == 0){
+    if (ring_enter(0, 1) < 0){
+      printf("Error waiting for io_uring completions: %s\n", strerror(errno));
+      return NULL;
+    }
+    reap_completions();
+  }
+  md_async_op_t * op = done[done_start];
+  done_start = (done_start + 1) % done_size;
+  done_count--;
+  return op;
+}
+
+// the blocking interface submits a single chain and waits for it, no other operation is in flight
+static int run_sync(md_op_type type, char * filename, char * buf, size_t size){
+  md_async_op_t op;
+  op.type = type;
+  op.dset = NULL;
+  op.name = filename;
+  op.buf = buf;
+  op.size = size;
+  int ret = submit_op(& op);
+  if (ret != MD_SUCCESS){
+    return ret;
+  }
+  complete_op();
+  return op.ret;
+}
+
+static int prepare_global(){
+  int ret = mkdir(dir, 0755);
+  if(ret != 0){
+    // check if the directory is empty
+    DIR * d = opendir(dir);
+    if( d == NULL ) goto err;
+    struct dirent * entry;
+    int i;
+    for(i=0; i < 10; i++){
+      entry = readdir(d);
+      if(entry == NULL){
+        break;
+      }
+    }
+    closedir(d);
+
+    if (i == 2){
+      printf("WARN: Will use the existing (empty) directory\n");
+      return MD_SUCCESS;
+    }
+    err:
+      printf("ERROR: Could not create the directory: %s; error: %s\n", dir, strerror(errno));
+      return MD_EXISTS;
+  }
+  created_root_dir = 1;
+  return MD_SUCCESS;
+}
+
+static int purge_global(){
+  if(created_root_dir){
+    return rmdir(dir);
+  }
+  return MD_SUCCESS;
+}
+
+static int def_dset_name(char * out_name, int n, int d){
+  sprintf(out_name, "%s/%d_%d", dir, n, d);
+  return MD_SUCCESS;
+}
+
+static int def_obj_name(char * out_name, int n, int d, int i){
+  sprintf(out_name, "%s/%d_%d/file-%d", dir, n, d, i);
+  return MD_SUCCESS;
+}
+
+static int create_dset(char * filename){
+  return mkdir(filename, 0755);
+}
+
+static int rm_dset(char * filename){
+  return rmdir(filename);
+}
+
+static int write_obj(char * dirname, char * filename, char * buf, size_t file_size){
+  return run_sync(MD_OP_WRITE, filename, buf, file_size);
+}
+
+static int read_obj(char * dirname, char * filename, char * buf, size_t file_size){
+  return run_sync(MD_OP_READ, filename, buf, file_size);
+}
+
+static int stat_obj(char * dirname, char * filename, size_t file_size){
+  return run_sync(MD_OP_STAT, filename, NULL, file_size);
+}
+
+static int delete_obj(char * dirname, char * filename){
+  return run_sync(MD_OP_DELETE, filename, NULL, 0);
+}
+
+struct md_plugin md_plugin_iouring = {
+  "iouring",
+  get_options,
+  initialize,
+  finalize,
+  prepare_global,
+  purge_global,
+
+  def_dset_name,
+  create_dset,
+  rm_dset,
+
+  def_obj_name,
+  write_obj,
+  read_obj,
+  stat_obj,
+  delete_obj,
+
+  0, // thread_safe
+
+  submit_op,
+  complete_op,
+
+  NULL, // write_objs
+  NULL, // read_objs
+  NULL, // stat_objs
+  NULL, // delete_objs
+
+  md_posix_evict_obj,
+  md_posix_obj_residency,
+
+  md_posix_def_subdir_name,
+  md_posix_def_subdir_obj_name
+};
@@ -0,0 +1,25 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_PLUGIN_IOURING_H
+#define MD_PLUGIN_IOURING_H
+
+#include <plugins/md-plugin.h>
+
+extern struct md_plugin md_plugin_iouring;
+
+#endif
@@ -199,12 +199,7 @@ static int rm_dset(char * obj_name){
   return MD_NOOP;
 }
 
-static void construct_access(char * collname, char * obj_name, mongoc_collection_t ** out_collection, bson_t ** out_doc){
-  if(collection_per_dir){
-    *out_collection = mongoc_database_get_collection(mongo_db, collname);
-  }else{
-    *out_collection = global_collection;
-  }
+static bson_t * construct_doc(char * obj_name){
   bson_t *doc;
 
   doc = bson_new();
@@ -216,8 +211,16 @@ static void construct_access(char * collname, char * obj_name, mongoc_collection
   }else{
     bson_append_utf8(doc, "_id", 3, obj_name, strlen(obj_name));
   }
+  return doc;
+}
 
-  *out_doc = doc;
+static void construct_access(char * collname, char * obj_name, mongoc_collection_t ** out_collection, bson_t ** out_doc){
+  if(collection_per_dir){
+    *out_collection = mongoc_database_get_collection(mongo_db, collname);
+  }else{
+    *out_collection = global_collection;
+  }
+  *out_doc = construct_doc(obj_name);
 }
 
 static void free_access(mongoc_collection_t * collection, bson_t * doc){
@@ -308,6 +311,51 @@ static int delete_obj(char * collname, char * obj_name){
   return MD_SUCCESS;
 }
 
+// insert or remove the objects with one unordered bulk operation per run of objects in the same collection
+static int bulk_objs(md_obj_t * objs, int count, int insert){
+  for(int i=0; i < count; ){
+    mongoc_collection_t * collection = collection_per_dir ? mongoc_database_get_collection(mongo_db, objs[i].dset) : global_collection;
+    mongoc_bulk_operation_t * bulk = mongoc_collection_create_bulk_operation(collection, false, NULL);
+    int run = 0;
+    do{
+      md_obj_t * obj = & objs[i + run];
+      bson_t * doc = construct_doc(obj->name);
+      if(insert){
+        bson_append_binary (doc, "data", 4, BSON_SUBTYPE_BINARY, (const uint8_t*) obj->buf, obj->size);
+        mongoc_bulk_operation_insert(bulk, doc);
+      }else{
+        mongoc_bulk_operation_remove_one(bulk, doc);
+      }
+      bson_destroy (doc);
+      run++;
+    }while(i + run < count && (! collection_per_dir || strcmp(objs[i + run].dset, objs[i].dset) == 0));
+
+    bson_error_t error;
+    int ret = MD_SUCCESS;
+    if (! mongoc_bulk_operation_execute(bulk, NULL, & error)){
+      printf("Error: %s\n", error.message);
+      ret = MD_ERROR_UNKNOWN;
+    }
+    for(int j=i; j < i + run; j++){
+      objs[j].ret = ret;
+    }
+    mongoc_bulk_operation_destroy(bulk);
+    if(collection_per_dir){
+      mongoc_collection_destroy (collection);
+    }
+    i += run;
+  }
+  return MD_SUCCESS;
+}
+
+static int write_objs(md_obj_t * objs, int count){
+  return bulk_objs(objs, count, 1);
+}
+
+static int delete_objs(md_obj_t * objs, int count){
+  return bulk_objs(objs, count, 0);
+}
+
 struct md_plugin md_plugin_mongo = {
   "mongo",
   get_options,
@@ -324,5 +372,21 @@ struct md_plugin md_plugin_mongo = {
   write_obj,
   read_obj,
   stat_obj,
-  delete_obj
+  delete_obj,
+
+  0, // thread_safe
+
+  NULL, // submit_op
+  NULL, // complete_op
+
+  write_objs,
+  NULL, // read_objs
+  NULL, // stat_objs
+  delete_objs,
+
+  NULL, // evict_obj
+  NULL, // obj_residency
+
+  NULL, // def_subdir_name
+  NULL  // def_subdir_obj_name
 };
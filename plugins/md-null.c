@@ -0,0 +1,126 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+/*
+ The null backend does nothing and does not format names, it is used to measure the overhead
+ of the benchmark harness itself, see test/harness-overhead.sh.
+*/
+
+#include <plugins/md-null.h>
+
+static option_help options [] = {
+  LAST_OPTION
+};
+
+static option_help * get_options(){
+  return options;
+}
+
+static int initialize(){
+  return MD_SUCCESS;
+}
+
+static int finalize(){
+  return MD_SUCCESS;
+}
+
+static int prepare_global(){
+  return MD_SUCCESS;
+}
+
+static int purge_global(){
+  return MD_SUCCESS;
+}
+
+static int def_dset_name(char * out_name, int n, int d){
+  out_name[0] = 0;
+  return MD_SUCCESS;
+}
+
+static int def_obj_name(char * out_name, int n, int d, int i){
+  out_name[0] = 0;
+  return MD_SUCCESS;
+}
+
+static int def_subdir_name(char * out_name, char * parent, int child){
+  out_name[0] = 0;
+  return MD_SUCCESS;
+}
+
+static int def_subdir_obj_name(char * out_name, char * dir, int n, int d, int i){
+  out_name[0] = 0;
+  return MD_SUCCESS;
+}
+
+static int create_dset(char * filename){
+  return MD_SUCCESS;
+}
+
+static int rm_dset(char * filename){
+  return MD_SUCCESS;
+}
+
+static int write_obj(char * dirname, char * filename, char * buf, size_t file_size){
+  return MD_SUCCESS;
+}
+
+static int read_obj(char * dirname, char * filename, char * buf, size_t file_size){
+  return MD_SUCCESS;
+}
+
+static int stat_obj(char * dirname, char * filename, size_t file_size){
+  return MD_SUCCESS;
+}
+
+static int delete_obj(char * dirname, char * filename){
+  return MD_SUCCESS;
+}
+
+struct md_plugin md_plugin_null = {
+  "null",
+  get_options,
+  initialize,
+  finalize,
+  prepare_global,
+  purge_global,
+
+  def_dset_name,
+  create_dset,
+  rm_dset,
+
+  def_obj_name,
+  write_obj,
+  read_obj,
+  stat_obj,
+  delete_obj,
+
+  1, // thread_safe
+
+  NULL, // submit_op
+  NULL, // complete_op
+
+  NULL, // write_objs
+  NULL, // read_objs
+  NULL, // stat_objs
+  NULL, // delete_objs
+
+  NULL, // evict_obj
+  NULL, // obj_residency
+
+  def_subdir_name,
+  def_subdir_obj_name
+};
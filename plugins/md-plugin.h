@@ -18,10 +18,37 @@
 #ifndef MD_PLUGIN_H
 #define MD_PLUGIN_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <md_option.h>
 
+typedef enum{
+  MD_OP_WRITE,
+  MD_OP_READ,
+  MD_OP_STAT,
+  MD_OP_DELETE
+} md_op_type;
+
+// an operation issued via the asynchronous interface, it is owned by the benchmark
+typedef struct{
+  md_op_type type;
+  char * dset;
+  char * name;
+  char * buf;
+  size_t size; // the buffer size for read/write, the expected object size for stat
+  int ret; // set by the plugin once the operation completed
+} md_async_op_t;
+
+// an object of a batched operation
+typedef struct{
+  char * dset;
+  char * name;
+  char * buf; // NULL for stat and delete
+  size_t size; // the buffer size for read/write, the expected object size for stat
+  int ret; // the result for this object
+} md_obj_t;
+
 struct md_plugin{
   char * name; // the name of the plugin, needed for -I option
 
@@ -50,6 +77,33 @@ struct md_plugin{
   int (*read_obj)(char * dset, char * name, char * buf, size_t size);
   int (*stat_obj)(char * dset, char * name, size_t object_size);
   int (*delete_obj)(char * dset, char * name);
+
+  // set to 1 if the object functions may be called concurrently by multiple threads, see --threads
+  int thread_safe;
+
+  // optional asynchronous interface, if NULL the blocking functions above are used
+  // start the operation, the op must not be touched by the benchmark until it is returned by complete_op
+  int (*submit_op)(md_async_op_t * op);
+  // wait until any submitted operation completes and return it
+  md_async_op_t * (*complete_op)();
+
+  // optional batched interface, if NULL the single object functions are called for each object, see --batch
+  // the result for each object is stored in its ret field, an error returned for the batch applies to all objects
+  int (*write_objs)(md_obj_t * objs, int count);
+  int (*read_objs)(md_obj_t * objs, int count);
+  int (*stat_objs)(md_obj_t * objs, int count);
+  int (*delete_objs)(md_obj_t * objs, int count);
+
+  // optional, evict the object from the caches of the client so that the next access misses them, see --cache-policy
+  int (*evict_obj)(char * dset, char * name);
+  // optional, count the pages of the object and how many of them are in the cache of the client, see --cache-residency
+  int (*obj_residency)(char * dset, char * name, uint64_t * resident_pages, uint64_t * pages);
+
+  // optional, the directory trees below the data sets, see --tree-depth
+  // the name of the child-th directory below the data set or directory parent, it is created with create_dset
+  int (*def_subdir_name)(char * out_name, char * parent, int child);
+  // the name of the object i of data set d of rank n placed inside the directory dir
+  int (*def_subdir_obj_name)(char * out_name, char * dir, int n, int d, int i);
 };
 
 enum MD_ERROR{
@@ -0,0 +1,81 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <plugins/md-posix-common.h>
+
+int md_posix_evict_obj(char * dirname, char * filename){
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) return MD_ERROR_FIND;
+  // dirty pages are not dropped, thus they are written back first
+  fdatasync(fd);
+  int ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+  return ret == 0 ? MD_SUCCESS : MD_ERROR_UNKNOWN;
+}
+
+int md_posix_obj_residency(char * dirname, char * filename, uint64_t * resident_pages, uint64_t * pages){
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) return MD_ERROR_FIND;
+  struct stat file_stats;
+  if(fstat(fd, & file_stats) != 0){
+    close(fd);
+    return MD_ERROR_FIND;
+  }
+  *resident_pages = 0;
+  *pages = 0;
+  if(file_stats.st_size == 0){
+    close(fd);
+    return MD_SUCCESS;
+  }
+  // the mapping is not accessed, thus mincore does not fault in any page
+  const size_t pagesize = getpagesize();
+  const size_t count = (file_stats.st_size + pagesize - 1) / pagesize;
+  void * p = mmap(NULL, file_stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED){
+    return MD_ERROR_UNKNOWN;
+  }
+  unsigned char * vec = malloc(count);
+  int ret = mincore(p, file_stats.st_size, vec);
+  if(ret == 0){
+    for(size_t i=0; i < count; i++){
+      *resident_pages += vec[i] & 1;
+    }
+    *pages = count;
+  }
+  free(vec);
+  munmap(p, file_stats.st_size);
+  return ret == 0 ? MD_SUCCESS : MD_ERROR_UNKNOWN;
+}
+
+int md_posix_def_subdir_name(char * out_name, char * parent, int child){
+  sprintf(out_name, "%s/t%d", parent, child);
+  return MD_SUCCESS;
+}
+
+int md_posix_def_subdir_obj_name(char * out_name, char * dir, int n, int d, int i){
+  sprintf(out_name, "%s/file-%d", dir, i);
+  return MD_SUCCESS;
+}
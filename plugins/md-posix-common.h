@@ -0,0 +1,38 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_PLUGIN_POSIX_COMMON_H
+#define MD_PLUGIN_POSIX_COMMON_H
+
+/*
+ The functions shared by the plugins storing the objects as files of the local file system, i.e., posix and iouring.
+ They match the signatures of the optional functions of struct md_plugin.
+ The names of the directory trees are also used by the dummy plugin.
+*/
+
+#include <plugins/md-plugin.h>
+
+// drop the pages of the file from the page cache, see --cache-policy
+int md_posix_evict_obj(char * dirname, char * filename);
+// count the pages of the file and how many of them are in the page cache, see --cache-residency
+int md_posix_obj_residency(char * dirname, char * filename, uint64_t * resident_pages, uint64_t * pages);
+
+// the directory tree below a data set, see --tree-depth
+int md_posix_def_subdir_name(char * out_name, char * parent, int child);
+int md_posix_def_subdir_obj_name(char * out_name, char * dir, int n, int d, int i);
+
+#endif
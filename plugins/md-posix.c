@@ -26,6 +26,7 @@
 #include <assert.h>
 
 #include <plugins/md-posix.h>
+#include <plugins/md-posix-common.h>
 
 static char * dir = "out";
 static int created_root_dir = 0;
@@ -164,6 +165,9 @@ static int stat_obj(char * dirname, char * filename, size_t file_size){
   if ( ret != 0 ){
     return MD_ERROR_FIND;
   }
+  if ( (size_t) file_stats.st_size != file_size ){
+    return MD_ERROR_UNKNOWN;
+  }
   return MD_SUCCESS;
 }
 
@@ -174,6 +178,7 @@ static int delete_obj(char * dirname, char * filename){
 
 
 
+
 struct md_plugin md_plugin_posix = {
   "posix",
   get_options,
@@ -190,5 +195,21 @@ struct md_plugin md_plugin_posix = {
   write_obj,
   read_obj,
   stat_obj,
-  delete_obj
+  delete_obj,
+
+  1, // thread_safe
+
+  NULL, // submit_op
+  NULL, // complete_op
+
+  NULL, // write_objs
+  NULL, // read_objs
+  NULL, // stat_objs
+  NULL, // delete_objs
+
+  md_posix_evict_obj,
+  md_posix_obj_residency,
+
+  md_posix_def_subdir_name,
+  md_posix_def_subdir_obj_name
 };
@@ -280,6 +280,207 @@ static int delete_obj(char * dset_name, char * obj_name){
   return MD_SUCCESS;
 }
 
+/* The batched functions issue one statement per run of consecutive objects in the same table,
+   writes and deletes of a batch are wrapped into one transaction. */
+
+static int exec_cmd(const char * SQL){
+  PGresult * res = PQexec(conn, SQL);
+  if (PQresultStatus(res) != PGRES_COMMAND_OK){
+    printf("PSQL error (%s): %s - Connection: %s SQL: %s\n", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res), PQerrorMessage(conn), SQL);
+    PQclear(res);
+    return MD_ERROR_UNKNOWN;
+  }
+  PQclear(res);
+  return MD_SUCCESS;
+}
+
+// the number of consecutive objects stored in the same table as the first object
+static int same_dset_count(md_obj_t * objs, int count){
+  int i = 1;
+  while(i < count && strcmp(objs[i].dset, objs[0].dset) == 0){
+    i++;
+  }
+  return i;
+}
+
+static char * alloc_sql(md_obj_t * objs, int count){
+  size_t len = 256 + strlen(objs[0].dset);
+  for(int i=0; i < count; i++){
+    len += strlen(objs[i].name) + 32;
+  }
+  return malloc(len);
+}
+
+// append the list of object names for an IN clause
+static int append_name_list(char * SQL, md_obj_t * objs, int count){
+  int pos = 0;
+  for(int i=0; i < count; i++){
+    pos += sprintf(SQL + pos, "%s'%s'", i == 0 ? "" : ",", objs[i].name);
+  }
+  return pos;
+}
+
+static md_obj_t * find_obj(md_obj_t * objs, int count, const char * obj_name){
+  for(int i=0; i < count; i++){
+    if(strcmp(objs[i].name, obj_name) == 0){
+      return & objs[i];
+    }
+  }
+  return NULL;
+}
+
+static int write_objs_dset(md_obj_t * objs, int count){
+  char * SQL = alloc_sql(objs, count);
+  int pos = sprintf(SQL, "INSERT INTO %s(obj_name, data) VALUES", objs[0].dset);
+  const char ** values = malloc(sizeof(char*) * count);
+  int * sizes = malloc(sizeof(int) * count);
+  int * formats = malloc(sizeof(int) * count);
+  for(int i=0; i < count; i++){
+    pos += sprintf(SQL + pos, "%s('%s', $%d::bytea)", i == 0 ? "" : ",", objs[i].name, i + 1);
+    values[i] = objs[i].buf;
+    sizes[i] = (int) objs[i].size;
+    formats[i] = 1;
+  }
+  int ret = MD_SUCCESS;
+  PGresult * res = PQexecParams(conn, SQL, count, NULL, values, sizes, formats, 1);
+  if (PQresultStatus(res) != PGRES_COMMAND_OK){
+    printf("PSQL error (%s): %s - Connection: %s SQL: %s\n", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res), PQerrorMessage(conn), SQL);
+    ret = MD_ERROR_UNKNOWN;
+  }
+  PQclear(res);
+  free(formats);
+  free(sizes);
+  free(values);
+  free(SQL);
+  return ret;
+}
+
+static int write_objs(md_obj_t * objs, int count){
+  int ret = exec_cmd("BEGIN");
+  if (ret != MD_SUCCESS){
+    return ret;
+  }
+  for(int i=0; i < count; ){
+    const int run = same_dset_count(objs + i, count - i);
+    ret = write_objs_dset(objs + i, run);
+    if (ret != MD_SUCCESS){
+      exec_cmd("ROLLBACK");
+      return ret;
+    }
+    i += run;
+  }
+  ret = exec_cmd("COMMIT");
+  for(int i=0; i < count; i++){
+    objs[i].ret = ret;
+  }
+  return ret;
+}
+
+// select the column for all objects, the callback handles each returned row
+static void select_objs_dset(md_obj_t * objs, int count, const char * column, int binary, void (*row_cb)(md_obj_t * obj, PGresult * res, int row)){
+  char * SQL = alloc_sql(objs, count);
+  int pos = sprintf(SQL, "SELECT obj_name, %s FROM %s WHERE obj_name IN (", column, objs[0].dset);
+  pos += append_name_list(SQL + pos, objs, count);
+  sprintf(SQL + pos, ")");
+
+  for(int i=0; i < count; i++){
+    objs[i].ret = MD_ERROR_UNKNOWN;
+  }
+  PGresult * res = PQexecParams(conn, SQL, 0, NULL, NULL, NULL, NULL, binary);
+  if (PQresultStatus(res) != PGRES_TUPLES_OK){
+    printf("PSQL error (%s): %s - Connection: %s SQL: %s\n", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res), PQerrorMessage(conn), SQL);
+  }else{
+    for(int r=0; r < PQntuples(res); r++){
+      md_obj_t * obj = find_obj(objs, count, PQgetvalue(res, r, 0));
+      if(obj){
+        row_cb(obj, res, r);
+      }
+    }
+  }
+  PQclear(res);
+  free(SQL);
+}
+
+static void read_row(md_obj_t * obj, PGresult * res, int row){
+  size_t size = PQgetlength(res, row, 1);
+  if (size != obj->size){
+    obj->ret = MD_ERROR_UNKNOWN;
+    return;
+  }
+  memcpy(obj->buf, PQgetvalue(res, row, 1), size);
+  obj->ret = MD_SUCCESS;
+}
+
+static void stat_row(md_obj_t * obj, PGresult * res, int row){
+  if ((size_t) atoll(PQgetvalue(res, row, 1)) != obj->size){
+    obj->ret = MD_ERROR_FIND;
+    return;
+  }
+  obj->ret = MD_SUCCESS;
+}
+
+static int read_objs(md_obj_t * objs, int count){
+  for(int i=0; i < count; ){
+    const int run = same_dset_count(objs + i, count - i);
+    select_objs_dset(objs + i, run, "data", 1, read_row);
+    i += run;
+  }
+  return MD_SUCCESS;
+}
+
+static int stat_objs(md_obj_t * objs, int count){
+  for(int i=0; i < count; ){
+    const int run = same_dset_count(objs + i, count - i);
+    select_objs_dset(objs + i, run, "octet_length(data)", 0, stat_row);
+    i += run;
+  }
+  return MD_SUCCESS;
+}
+
+static int delete_objs_dset(md_obj_t * objs, int count){
+  char * SQL = alloc_sql(objs, count);
+  int pos = sprintf(SQL, "DELETE FROM %s WHERE obj_name IN (", objs[0].dset);
+  pos += append_name_list(SQL + pos, objs, count);
+  sprintf(SQL + pos, ") RETURNING obj_name");
+
+  for(int i=0; i < count; i++){
+    objs[i].ret = MD_ERROR_UNKNOWN;
+  }
+  int ret = MD_SUCCESS;
+  PGresult * res = PQexec(conn, SQL);
+  if (PQresultStatus(res) != PGRES_TUPLES_OK){
+    printf("PSQL error (%s): %s - Connection: %s SQL: %s\n", PQresStatus(PQresultStatus(res)), PQresultErrorMessage(res), PQerrorMessage(conn), SQL);
+    ret = MD_ERROR_UNKNOWN;
+  }else{
+    for(int r=0; r < PQntuples(res); r++){
+      md_obj_t * obj = find_obj(objs, count, PQgetvalue(res, r, 0));
+      if(obj){
+        obj->ret = MD_SUCCESS;
+      }
+    }
+  }
+  PQclear(res);
+  free(SQL);
+  return ret;
+}
+
+static int delete_objs(md_obj_t * objs, int count){
+  int ret = exec_cmd("BEGIN");
+  if (ret != MD_SUCCESS){
+    return ret;
+  }
+  for(int i=0; i < count; ){
+    const int run = same_dset_count(objs + i, count - i);
+    ret = delete_objs_dset(objs + i, run);
+    if (ret != MD_SUCCESS){
+      exec_cmd("ROLLBACK");
+      return ret;
+    }
+    i += run;
+  }
+  return exec_cmd("COMMIT");
+}
+
 
 struct md_plugin md_plugin_postgres = {
   "postgres",
@@ -297,5 +498,21 @@ struct md_plugin md_plugin_postgres = {
   write_obj,
   read_obj,
   stat_obj,
-  delete_obj
+  delete_obj,
+
+  0, // thread_safe
+
+  NULL, // submit_op
+  NULL, // complete_op
+
+  write_objs,
+  read_objs,
+  stat_objs,
+  delete_objs,
+
+  NULL, // evict_obj
+  NULL, // obj_residency
+
+  NULL, // def_subdir_name
+  NULL  // def_subdir_obj_name
 };
@@ -310,5 +310,21 @@ struct md_plugin md_plugin_s3 = {
   write_obj,
   read_obj,
   stat_obj,
-  delete_obj
+  delete_obj,
+
+  0, // thread_safe
+
+  NULL, // submit_op
+  NULL, // complete_op
+
+  NULL, // write_objs
+  NULL, // read_objs
+  NULL, // stat_objs
+  NULL, // delete_objs
+
+  NULL, // evict_obj
+  NULL, // obj_residency
+
+  NULL, // def_subdir_name
+  NULL  // def_subdir_obj_name
 };
@@ -0,0 +1,99 @@
+// This file is part of MD-Workbench.
+//
+// MD-Workbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-Workbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-Workbench.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+/*
+ Convert a binary trace written with --trace to CSV.
+ With only the trace file, all records are printed.
+ With a rank and an operation type, the latency file of the rank is printed in the format of -L.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <md_trace.h>
+
+static const char * type_names[] = {"write", "read", "stat", "delete"};
+
+static int find_type(const char * name){
+  // -L names the latency files of writes create
+  if(strcmp(name, "create") == 0){
+    return 0;
+  }
+  for(int i=0; i < 4; i++){
+    if(strcmp(type_names[i], name) == 0){
+      return i;
+    }
+  }
+  return -1;
+}
+
+int main(int argc, char ** argv){
+  if(argc != 2 && argc != 4){
+    printf("Synopsis: %s <trace file> [<rank> <write|read|stat|delete>]\n", argv[0]);
+    return 1;
+  }
+  int filter_rank = -1;
+  int filter_type = -1;
+  if(argc == 4){
+    filter_rank = atoi(argv[2]);
+    filter_type = find_type(argv[3]);
+    if(filter_type < 0){
+      printf("Unknown operation type: %s\n", argv[3]);
+      return 1;
+    }
+  }
+
+  FILE * f = fopen(argv[1], "rb");
+  if(f == NULL){
+    printf("Error opening the trace file: %s\n", argv[1]);
+    return 1;
+  }
+  md_trace_header_t header;
+  if(fread(& header, sizeof(header), 1, f) != 1 || memcmp(header.magic, MD_TRACE_MAGIC, sizeof(header.magic)) != 0){
+    printf("Error, %s is not a trace file or has been written on a machine with different byte order\n", argv[1]);
+    fclose(f);
+    return 1;
+  }
+  if(header.version != MD_TRACE_VERSION || header.record_size != sizeof(md_trace_record_t)){
+    printf("Error, unsupported trace version %u with record size %u\n", header.version, header.record_size);
+    fclose(f);
+    return 1;
+  }
+  fseek(f, header.header_size, SEEK_SET);
+
+  if(filter_rank < 0){
+    printf("start,runtime,type,rank,obj_rank,dset,obj,ret\n");
+  }else{
+    printf("time,runtime\n");
+  }
+  md_trace_record_t r;
+  for(uint64_t i = 0; i < header.record_count; i++){
+    if(fread(& r, sizeof(r), 1, f) != 1){
+      printf("Error, the trace is truncated after %llu records\n", (long long unsigned) i);
+      fclose(f);
+      return 1;
+    }
+    if(filter_rank < 0){
+      printf("%.9f,%.9f,%s,%d,%d,%d,%lld,%d\n", r.start / 1e9, r.runtime / 1e9, r.type < 4 ? type_names[r.type] : "unknown", r.rank, r.obj_rank, r.dset, (long long) r.obj, r.ret);
+    }else if(r.rank == filter_rank && r.type == filter_type){
+      printf("%.7f,%.4e\n", r.start / 1e9, r.runtime / 1e9);
+    }
+  }
+  fclose(f);
+  return 0;
+}
@@ -16,7 +16,8 @@
 // Author: Julian Kunkel
 
 #include <mpi.h>
-
+#include <pthread.h>
+#include <sys/resource.h>
 
 #include <time.h>
 #include <stdint.h>
@@ -24,22 +25,36 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <math.h>
+#include <unistd.h>
 
 #include <md_util.h>
 #include <md_option.h>
+#include <md_histogram.h>
+#include <md_interval.h>
+#include <md_trace.h>
+#include <md_latency_writer.h>
+#include <md_timeline.h>
+#include <md_perf_counters.h>
+#include <md_mix.h>
+#include <md_size_dist.h>
+#include <md_replay.h>
 
 #include <plugins/md-plugin.h>
 
 #include <plugins/md-dummy.h>
+#include <plugins/md-null.h>
 #include <plugins/md-posix.h>
 #include <plugins/md-postgres.h>
 #include <plugins/md-mongo.h>
 #include <plugins/md-s3.h>
 #include <plugins/md-mpi.h>
+#include <plugins/md-iouring.h>
 
 struct md_plugin * md_plugin_list[] = {
 & md_plugin_dummy,
+& md_plugin_null,
 & md_plugin_posix,
 #ifdef MD_PLUGIN_MPIIO
 & md_plugin_mpi,
@@ -53,6 +68,9 @@ struct md_plugin * md_plugin_list[] = {
 #ifdef MD_PLUGIN_S3
 & md_plugin_s3,
 #endif
+#ifdef MD_PLUGIN_IOURING
+& md_plugin_iouring,
+#endif
 NULL
 };
 
@@ -89,6 +107,12 @@ typedef struct{
   float max;
 } time_statistics_t;
 
+// the pages of objects and how many of them are in the cache
+typedef struct{
+  uint64_t resident;
+  uint64_t pages;
+} residency_t;
+
 // statistics for running a single phase
 typedef struct{ // NOTE: if this type is changed, adjust end_phase() !!!
   double t; // maximum time
@@ -116,12 +140,66 @@ typedef struct{ // NOTE: if this type is changed, adjust end_phase() !!!
   time_statistics_t stats_stat;
   time_statistics_t stats_delete;
 
+  // the latency of whole batches, see --batch
+  time_statistics_t stats_batch_create;
+  time_statistics_t stats_batch_read;
+  time_statistics_t stats_batch_stat;
+  time_statistics_t stats_batch_delete;
+
   // the maximum time for any single operation
   double max_op_time;
   timer phase_start_timer;
   int stonewall_iterations;
+  int mix_iterations; // the iterations of the benchmark phase, see --mix
+  // the bytes of the successful writes and reads
+  uint64_t bytes_written;
+  uint64_t bytes_read;
+  // the number of operations started later than the tolerance after their intended start time, see --target-rate
+  int missed_deadlines;
+
+  // latency histograms in ns, all histograms are stored contiguously to reduce them at once
+  md_histogram_t * hist_create;
+  md_histogram_t * hist_read;
+  md_histogram_t * hist_stat;
+  md_histogram_t * hist_delete;
+  md_histogram_t * hist_batch_create;
+  md_histogram_t * hist_batch_read;
+  md_histogram_t * hist_batch_stat;
+  md_histogram_t * hist_batch_delete;
+  // the latency of the stats by the depth of the object in the tree, see --tree-depth
+  md_histogram_t * hist_depth;
+
+  // the ring of the latency writer used by the thread, the time the process waited for the writer
+  int writer_ring;
+  double writer_blocked;
+
+  // the sampled pages of the objects and how many of them are cached, see --cache-residency
+  residency_t cache_before;
+  residency_t cache_after;
+  residency_t cache_read; // the objects read by the benchmark
+
+  // the counters of the process during the phase and of the operations by md_op_type, see --perf-counters
+  uint64_t perf_phase[MD_PC_COUNT];
+  uint64_t perf_ops[4][MD_PC_COUNT];
+  uint64_t perf_op_count[4];
+  uint64_t perf_multiplexed[MD_PC_COUNT]; // the number of processes that multiplexed the counter in the phase
+
+  // the thread CPU time and the wall time of the operations by md_op_type and the CPU time of the process, see --cpu-time
+  uint64_t cpu_op_start;
+  double cpu_op[4];
+  double cpu_op_wall[4];
+  double cpu_user;
+  double cpu_sys;
+  uint64_t cpu_op_count[4];
+
+  // the records of all operations, see --trace
+  md_trace_record_t * trace;
+  size_t trace_count;
+  size_t trace_capacity;
 } phase_stat_t;
 
+#define HIST_COUNT 8
+
 #define CHECK_MPI_RET(ret) if (ret != MPI_SUCCESS){ printf("Unexpected error in MPI on Line %d\n", __LINE__);}
 #define LLU (long long unsigned)
 #define min(a,b) (a < b ? a : b)
@@ -133,16 +211,31 @@ struct benchmark_options{
   int num;
   int precreate;
   int dset_count;
+  int shared_dsets;
+  int tree_depth;
+  int tree_fanout;
 
   int offset;
   int iterations;
   int file_size;
+  char * size_dist;
   int read_only;
   int stonewall_timer;
   int stonewall_timer_wear_out;
+  int duration;
+  float report_interval;
+  char * heatmap_prefix;
 
   char * latency_file_prefix;
+  char * trace_prefix;
+  char * trace_events_file;
+  char * mix;
+  char * mix_file;
+  char * replay;
+  float replay_speed;
   int latency_keep_all;
+  int latency_exact;
+  int latency_precision;
 
   int phase_cleanup;
   int phase_precreate;
@@ -150,6 +243,7 @@ struct benchmark_options{
 
   int limit_memory;
   int limit_memory_between_phases;
+  char * limit_memory_log;
 
   int verbosity;
   int process_report;
@@ -166,28 +260,254 @@ struct benchmark_options{
   float relative_waiting_factor;
   int adaptive_waiting_mode;
 
+  int threads;
+  int queue_depth;
+  int batch;
+
+  float target_rate;
+  char * arrival;
+  int arrival_poisson;
+  float deadline_tolerance;
+
+  int arena_hugepages;
+  int arena_lock;
+
+  char * cache_policy;
+  int cache_policy_id;
+  float cache_residency;
+
+  int perf_counters;
+  int perf_counters_ops;
+  int cpu_time;
+
+  char * timer_source;
+  int timer_subtract_overhead;
+  uint64_t timer_overhead; // in ns
+
   uint64_t start_item_number;
 };
 
 static int global_iteration = 0;
+// the declarative mix of the benchmark phase, see --mix
+static md_mix_t mix;
+static int use_mix = 0;
+// the objects per dataset of each process, with --mix the creates and deletes may change it
+static int working_set = 0;
+// the sizes of the objects, see --object-size-dist
+static md_size_dist_t size_dist;
+
+static inline size_t obj_size(int rank, int d, int64_t obj){
+  return md_size_dist_get(& size_dist, rank, d, obj);
+}
+// the trace of this process replayed instead of the phases and the largest object size of the trace, see --replay
+static md_replay_t * replay = NULL;
+static size_t replay_max_size = 0;
+// the rank of this process on its node
+static int node_rank = 0;
+
+// how the caches are prepared before each benchmark iteration, see --cache-policy
+typedef enum{
+  CACHE_WARM,
+  CACHE_EVICT,
+  CACHE_DROP
+} cache_policy_t;
+
+static const char * cache_policy_names[] = {"warm", "evict", "drop"};
 
 struct benchmark_options o;
 
+/* The data sets are shared by groups of --shared-dsets consecutive processes, they are named after the first
+   process of the group. The objects of the members are interleaved, the object i of a member m of a group with
+   k members is the object i * k + m of the group. Without sharing, each process is a group of its own. */
+static MPI_Comm shared_comm = MPI_COMM_NULL;
+
+static inline int shared_leader(int rank){
+  return rank / o.shared_dsets * o.shared_dsets;
+}
+
+static inline int shared_members(int rank){
+  const int leader = shared_leader(rank);
+  return o.size - leader < o.shared_dsets ? o.size - leader : o.shared_dsets;
+}
+
+static int define_dset_name(char * out_name, int n, int d){
+  return o.plugin->def_dset_name(out_name, shared_leader(n), d);
+}
+
+// the directory tree below each data set, see --tree-depth
+// the nodes are numbered in breadth-first order, node 0 is the data set, the first node of each depth
+#define MAX_TREE_DEPTH 16
+static int tree_nodes = 1;
+static int tree_first[MAX_TREE_DEPTH + 2] = {0, 1};
+
+static int tree_node_depth(int node){
+  int depth = 0;
+  while(node >= tree_first[depth + 1]){
+    depth++;
+  }
+  return depth;
+}
+
+// the name of the node of the tree of data set d of rank n
+static int tree_node_name(char * out_name, int n, int d, int node){
+  int children[MAX_TREE_DEPTH];
+  int depth = 0;
+  for(; node > 0; node = (node - 1) / o.tree_fanout){
+    children[depth++] = (node - 1) % o.tree_fanout;
+  }
+  int ret = define_dset_name(out_name, n, d);
+  char parent[4096];
+  while(depth > 0 && ret == MD_SUCCESS){
+    strcpy(parent, out_name);
+    ret = o.plugin->def_subdir_name(out_name, parent, children[--depth]);
+  }
+  return ret;
+}
+
+// the name of the object, with --tree-depth the objects are placed round-robin in the nodes of the tree
+static int define_obj_name(char * out_name, int n, int d, int i){
+  if(o.shared_dsets > 1){
+    const int leader = shared_leader(n);
+    const int64_t index = (int64_t) i * shared_members(n) + n - leader;
+    if(index > INT_MAX){
+      return MD_ERROR_UNKNOWN;
+    }
+    i = (int) index;
+    n = leader;
+  }
+  if(o.tree_depth == 0){
+    return o.plugin->def_obj_name(out_name, n, d, i);
+  }
+  char dir[4096];
+  const int ret = tree_node_name(dir, n, d, i % tree_nodes);
+  if(ret != MD_SUCCESS){
+    return ret;
+  }
+  return o.plugin->def_subdir_obj_name(out_name, dir, n, d, i);
+}
+
 void init_options(){
   memset(& o, 0, sizeof(o));
   o.interface = "posix";
   o.num = 1000;
   o.precreate = 3000;
   o.dset_count = 10;
+  o.shared_dsets = 1;
+  o.tree_fanout = 2;
   o.offset = 1;
   o.iterations = 3;
   o.file_size = 3901;
   o.run_info_file = "mdtest.status";
+  o.latency_precision = 7;
+  o.threads = 1;
+  o.queue_depth = 1;
+  o.batch = 1;
+  o.arrival = "poisson";
+  o.deadline_tolerance = 1e-5;
+  o.timer_source = "monotonic";
+  o.cache_policy = "warm";
+  o.heatmap_prefix = "heatmap";
 }
 
-static void wait(double runtime){
-  double waittime = runtime * o.relative_waiting_factor;
-  //printf("waittime: %e\n", waittime);
+static MPI_Datatype hist_type;
+static MPI_Op hist_op;
+
+// the periodic report of the running phase, see --report-interval
+static md_interval_t * interval_report = NULL;
+static MPI_Comm interval_comm;
+
+// streams the latency files of this process during the phase, see -L
+static md_lat_writer_t * latency_writer = NULL;
+
+// the trace-event export of all phases, see --trace-events
+static md_timeline_t * timeline = NULL;
+
+static void timeline_instant(const char * name){
+  if(timeline){
+    md_timeline_instant(timeline, name);
+  }
+}
+
+// the counters of the process including its threads, see --perf-counters
+static md_perf_counters_t perf_counters;
+// the counters available on all processes
+static int perf_available = 0;
+
+static void process_cpu_time(double * user, double * sys){
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, & usage);
+  *user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6;
+  *sys = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+// the counters of the process during the phase, see --perf-counters and --cpu-time
+static void phase_counters_start(phase_stat_t * s){
+  if(o.perf_counters){
+    md_perf_read(& perf_counters, s->perf_phase);
+    md_perf_multiplexed(& perf_counters);
+  }
+  if(o.cpu_time){
+    process_cpu_time(& s->cpu_user, & s->cpu_sys);
+  }
+}
+
+static void phase_counters_stop(phase_stat_t * s){
+  if(o.perf_counters){
+    uint64_t now[MD_PC_COUNT];
+    md_perf_read(& perf_counters, now);
+    const int multiplexed = md_perf_multiplexed(& perf_counters);
+    for(int i=0; i < MD_PC_COUNT; i++){
+      s->perf_phase[i] = now[i] - s->perf_phase[i];
+      s->perf_multiplexed[i] = (multiplexed >> i) & 1;
+    }
+  }
+  if(o.cpu_time){
+    double user, sys;
+    process_cpu_time(& user, & sys);
+    s->cpu_user = user - s->cpu_user;
+    s->cpu_sys = sys - s->cpu_sys;
+  }
+}
+
+// the thread CPU time of an operation is accounted in record_op(), see --cpu-time
+static inline void start_op_cpu(phase_stat_t * s){
+  if(o.cpu_time){
+    s->cpu_op_start = thread_cpu_ns();
+  }
+}
+
+// account the counters since the start of the operation to its type
+static void perf_op_add(phase_stat_t * s, md_op_type type, uint64_t start[MD_PC_COUNT]){
+  uint64_t now[MD_PC_COUNT];
+  md_perf_read(& perf_counters, now);
+  for(int i=0; i < MD_PC_COUNT; i++){
+    s->perf_ops[type][i] += now[i] - start[i];
+  }
+  s->perf_op_count[type]++;
+}
+
+// a counter multiplexed by any process is an estimate and marked as scaled
+static void print_perf(const char * name, const char * what, uint64_t values[MD_PC_COUNT], uint64_t ops, uint64_t multiplexed[MD_PC_COUNT]){
+  if(ops == 0){
+    return;
+  }
+  char buff[1024];
+  int pos = sprintf(buff, "%s perf %s", name, what);
+  for(int i=0; i < MD_PC_COUNT; i++){
+    if(perf_available & (1 << i)){
+      pos += sprintf(buff + pos, " %s:%.3f%s", md_perf_counter_names[i], (double) values[i] / ops, multiplexed[i] ? "(scaled)" : "");
+    }else{
+      pos += sprintf(buff + pos, " %s:-", md_perf_counter_names[i]);
+    }
+  }
+  const int ipc = (1 << MD_PC_CYCLES) | (1 << MD_PC_INSTRUCTIONS);
+  if((perf_available & ipc) == ipc && values[MD_PC_CYCLES] > 0){
+    pos += sprintf(buff + pos, " ipc:%.2f", (double) values[MD_PC_INSTRUCTIONS] / values[MD_PC_CYCLES]);
+  }
+  printf("%s\n", buff);
+}
+
+static void wait_for(double waittime){
   if(waittime < 0.01){
     timer start;
     start_timer(& start);
@@ -204,32 +524,284 @@ static void wait(double runtime){
   }
 }
 
-static void init_stats(phase_stat_t * p, size_t repeats){
+static void wait(double runtime){
+  double waittime = runtime * o.relative_waiting_factor;
+  //printf("waittime: %e\n", waittime);
+  wait_for(waittime);
+}
+
+// the intended start of the next operation for the open-loop load generation, see --target-rate
+typedef struct{
+  double next; // in seconds since the start of the phase
+  double rate; // operations per second of this thread
+  unsigned short seed[3];
+} arrival_t;
+
+static void arrival_init(arrival_t * a, int thread){
+  a->next = 0;
+  a->rate = o.target_rate / o.threads;
+  a->seed[0] = 0x330e;
+  a->seed[1] = (unsigned short) o.rank;
+  a->seed[2] = (unsigned short) thread;
+}
+
+/* Start the timer for the next operation.
+   In open-loop mode, wait until the intended start of the operation and start the timer at the intended time.
+   Thus, the latency includes the time an operation is delayed by slow predecessors (coordinated omission). */
+static void start_op_timer(phase_stat_t * s, arrival_t * a, timer * op_timer){
+  if(o.target_rate <= 0){
+    start_timer(op_timer);
+    return;
+  }
+  const double now = stop_timer(s->phase_start_timer);
+  if(now > a->next + o.deadline_tolerance){
+    s->missed_deadlines++;
+  }else if(now < a->next){
+    wait_for(a->next - now);
+  }
+  *op_timer = s->phase_start_timer;
+  timer_add(op_timer, a->next);
+  if(o.arrival_poisson){
+    a->next += -log(1.0 - erand48(a->seed)) / a->rate;
+  }else{
+    a->next += 1.0 / a->rate;
+  }
+}
+
+// the number of measurements for each thread, objects are distributed round-robin across the threads
+static size_t thread_slice(size_t repeats){
+  const size_t dsets = o.dset_count > 0 ? o.dset_count : 1;
+  return (repeats / dsets + o.threads - 1) / o.threads * dsets;
+}
+
+static void init_histograms(phase_stat_t * p){
+  const size_t hist_size = md_hist_size(o.latency_precision);
+  char * hist_block = malloc(HIST_COUNT * hist_size);
+  md_histogram_t ** hists = & p->hist_create;
+  for(int i=0; i < HIST_COUNT; i++){
+    hists[i] = (md_histogram_t *) (hist_block + i * hist_size);
+    md_hist_init(hists[i], o.latency_precision);
+  }
+  p->hist_depth = NULL;
+  if(o.tree_depth > 0){
+    hist_block = malloc((o.tree_depth + 1) * hist_size);
+    for(int i=0; i <= o.tree_depth; i++){
+      md_hist_init((md_histogram_t *) (hist_block + i * hist_size), o.latency_precision);
+    }
+    p->hist_depth = (md_histogram_t *) hist_block;
+  }
+}
+
+static md_histogram_t * depth_hist(md_histogram_t * hist_depth, int depth){
+  return (md_histogram_t *) ((char *) hist_depth + depth * md_hist_size(o.latency_precision));
+}
+
+// the individual samples are only gathered on rank 0 if explicitly requested, otherwise the histograms are used
+static int gather_samples(){
+  return o.latency_exact || (o.latency_keep_all && o.latency_file_prefix);
+}
+
+// the measurement buffers of all phases, allocated once for the largest phase before any timer is started
+typedef struct{
+  time_result_t * process; // the four buffers of the running phase
+  time_result_t * global; // rank 0: the four buffers for the gathered samples
+  size_t process_count; // the number of measurements per buffer
+  size_t global_count;
+  void * mem;
+  size_t size;
+} measurement_arena_t;
+
+static measurement_arena_t arena;
+
+// the largest working set during the run, see --mix
+static int max_working_set(){
+  int max = working_set > o.precreate ? working_set : o.precreate;
+  if(use_mix && o.phase_benchmark){
+    const int runs = o.iterations * (o.adaptive_waiting_mode ? 8 : 1);
+    const int grown = working_set + (mix.count[MD_OP_WRITE] - mix.count[MD_OP_DELETE]) * o.num * runs;
+    max = grown > max ? grown : max;
+  }
+  return max;
+}
+
+static int arena_init(){
+  const int max_set = max_working_set();
+  const size_t max_repeats = (size_t) (max_set > o.num ? max_set : o.num) * o.dset_count;
+  arena.process_count = thread_slice(max_repeats) * o.threads;
+  arena.global_count = o.rank == 0 && gather_samples() ? thread_slice(max_repeats * o.size) * o.threads : 0;
+  arena.size = 4 * (arena.process_count + arena.global_count) * sizeof(time_result_t);
+  arena.mem = mem_arena_alloc(& arena.size, o.arena_hugepages, o.arena_lock, o.verbosity);
+  if(arena.mem == NULL && arena.size > 0){
+    return -1;
+  }
+  arena.process = (time_result_t *) arena.mem;
+  arena.global = arena.global_count > 0 ? arena.process + 4 * arena.process_count : NULL;
+  return 0;
+}
+
+// the measurements are stored in the four consecutive buffers of the arena of the given size
+static void init_stats(phase_stat_t * p, size_t repeats, time_result_t * buffers, size_t buffer_count){
   memset(p, 0, sizeof(phase_stat_t));
   p->repeats = repeats;
-  size_t timer_size = repeats * sizeof(time_result_t);
-  p->time_create = (time_result_t *) malloc(timer_size);
-  p->time_read = (time_result_t *) malloc(timer_size);
-  p->time_stat = (time_result_t *) malloc(timer_size);
-  p->time_delete = (time_result_t *) malloc(timer_size);
+  if(buffers){
+    p->time_create = buffers;
+    p->time_read = buffers + buffer_count;
+    p->time_stat = buffers + 2 * buffer_count;
+    p->time_delete = buffers + 3 * buffer_count;
+  }
+  init_histograms(p);
+}
+
+// the latency of an operation, optionally without the overhead of reading the timer
+static uint64_t op_latency_ns(timer start){
+  timer end;
+  start_timer(& end);
+  uint64_t ns = timer_elapsed_ns(start, end);
+  if(o.timer_subtract_overhead){
+    ns = ns > o.timer_overhead ? ns - o.timer_overhead : 0;
+  }
+  return ns;
 }
 
-static float add_timed_result(timer start, timer phase_start_timer, time_result_t * results, size_t pos, double * max_time, double * out_op_time){
+static float add_timed_result(timer start, timer phase_start_timer, time_result_t * results, md_histogram_t * hist, size_t pos, double * max_time, uint64_t * out_ns){
+  const uint64_t ns = op_latency_ns(start);
   float curtime = timer_subtract(start, phase_start_timer);
-  double op_time = stop_timer(start);
+  double op_time = ns * 1e-9;
   results[pos].runtime = (float) op_time;
   results[pos].time_since_app_start = curtime;
+  md_hist_add(hist, ns);
+  if(interval_report){
+    md_interval_add(interval_report, ns);
+    md_interval_progress(interval_report);
+  }
   if (op_time > *max_time){
     *max_time = op_time;
   }
-  *out_op_time = op_time;
+  *out_ns = ns;
   return curtime;
 }
 
+// record the operation in the latency files and the trace of the phase and account its bytes
+static void record_op(phase_stat_t * s, md_op_type type, timer start, uint64_t ns, int obj_rank, int dset, int64_t obj, size_t size, int ret){
+  const double op_time = ns * 1e-9;
+  if(ret == MD_SUCCESS && (type == MD_OP_WRITE || type == MD_OP_READ)){
+    *(type == MD_OP_WRITE ? & s->bytes_written : & s->bytes_read) += size;
+  }
+  if(s->cpu_op_start){
+    // the operations of a batch share one start, the first one is accounted with the CPU time of the batch
+    const uint64_t now = thread_cpu_ns();
+    s->cpu_op[type] += (now - s->cpu_op_start) * 1e-9;
+    s->cpu_op_wall[type] += op_time;
+    s->cpu_op_count[type]++;
+    s->cpu_op_start = now;
+  }
+  if(type == MD_OP_STAT && s->hist_depth){
+    md_hist_add(depth_hist(s->hist_depth, tree_node_depth(obj % tree_nodes)), ns);
+  }
+  if(latency_writer){
+    md_lat_writer_push(latency_writer, s->writer_ring, type, timer_subtract(start, s->phase_start_timer), op_time);
+  }
+  if(timeline){
+    const char * names[] = {"write", "read", "stat", "delete"};
+    md_timeline_op(timeline, names[type], start, op_time, obj_rank, dset, obj, ret);
+  }
+  if(! o.trace_prefix){
+    return;
+  }
+  if(s->trace_count == s->trace_capacity){
+    s->trace_capacity = s->trace_capacity == 0 ? 1024 : s->trace_capacity * 2;
+    s->trace = realloc(s->trace, s->trace_capacity * sizeof(md_trace_record_t));
+  }
+  md_trace_record_t * r = & s->trace[s->trace_count++];
+  memset(r, 0, sizeof(md_trace_record_t));
+  r->start = (uint64_t) (timer_subtract(start, s->phase_start_timer) * 1e9 + 0.5);
+  r->runtime = ns;
+  r->obj = obj;
+  r->rank = o.rank;
+  r->obj_rank = obj_rank;
+  r->dset = dset;
+  r->ret = ret;
+  r->type = (uint8_t) type;
+}
+
+// write the trace of all processes into one shared file with collective I/O
+static void write_trace(const char * name, phase_stat_t * p){
+  char file[1024];
+  if(strcmp(name, "benchmark") == 0){
+    sprintf(file, "%s-%d-%s.trace", o.trace_prefix, global_iteration, name);
+  }else{
+    sprintf(file, "%s-%s.trace", o.trace_prefix, name);
+  }
+
+  uint64_t count = p->trace_count;
+  uint64_t offset = 0;
+  uint64_t total;
+  MPI_Exscan(& count, & offset, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(& count, & total, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+  if(o.rank == 0){
+    offset = 0; // undefined for MPI_Exscan
+  }
+
+  MPI_File fh;
+  int ret = MPI_File_open(MPI_COMM_WORLD, file, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, & fh);
+  if(ret != MPI_SUCCESS){
+    if(o.rank == 0){
+      printf("Error writing the trace file: %s\n", file);
+    }
+    return;
+  }
+  MPI_File_set_size(fh, 0);
+
+  MPI_Datatype record_type;
+  MPI_Type_contiguous(sizeof(md_trace_record_t), MPI_BYTE, & record_type);
+  MPI_Type_commit(& record_type);
+
+  if(o.rank == 0){
+    char header_buf[MD_TRACE_HEADER_SIZE];
+    md_trace_header_t * header = (md_trace_header_t *) header_buf;
+    memset(header_buf, 0, MD_TRACE_HEADER_SIZE);
+    memcpy(header->magic, MD_TRACE_MAGIC, sizeof(header->magic));
+    header->version = MD_TRACE_VERSION;
+    header->header_size = MD_TRACE_HEADER_SIZE;
+    header->record_size = sizeof(md_trace_record_t);
+    header->nprocs = o.size;
+    header->record_count = total;
+    snprintf(header->phase, sizeof(header->phase), "%s", name);
+    snprintf(header->fields, sizeof(header->fields), "%s", MD_TRACE_FIELDS);
+    snprintf(header->types, sizeof(header->types), "%s", MD_TRACE_TYPES);
+    MPI_File_write_at(fh, 0, header_buf, MD_TRACE_HEADER_SIZE, MPI_BYTE, MPI_STATUS_IGNORE);
+  }
+  ret = MPI_File_write_at_all(fh, MD_TRACE_HEADER_SIZE + offset * sizeof(md_trace_record_t), p->trace, (int) count, record_type, MPI_STATUS_IGNORE);
+  CHECK_MPI_RET(ret)
+  MPI_Type_free(& record_type);
+  MPI_File_close(& fh);
+}
+
 static void print_detailed_stat_header(){
     printf("phase\t\td name\tcreate\tdelete\tob nam\tcreate\tread\tstat\tdelete\tt_inc_b\tt_no_bar\tthp\tmax_t\n");
 }
 
+static void print_residency(char * buff, int * pos, const char * name, residency_t * r){
+  if(r->pages == 0){
+    *pos += sprintf(buff + *pos, "%s:-", name);
+  }else{
+    *pos += sprintf(buff + *pos, "%s:%.1f%%", name, r->resident * 100.0 / r->pages);
+  }
+}
+
+// the CPU time of all processes and per operation type
+static void print_cpu_time(const char * name, phase_stat_t * p){
+  const double cpu = p->cpu_user + p->cpu_sys;
+  printf("%s cpu user:%.3fs sys:%.3fs (%.1f%% sys)", name, p->cpu_user, p->cpu_sys, cpu > 0 ? p->cpu_sys / cpu * 100 : 0.0);
+  const char * op_names[] = {"create", "read", "stat", "delete"};
+  for(int t=0; t < 4; t++){
+    if(p->cpu_op_count[t] > 0){
+      printf(" %s(%.2fus/op, %.1f%% of wall)", op_names[t], p->cpu_op[t] / p->cpu_op_count[t] * 1e6, p->cpu_op_wall[t] > 0 ? p->cpu_op[t] / p->cpu_op_wall[t] * 100 : 0.0);
+    }
+  }
+  printf("\n");
+}
+
 static int sum_err(phase_stat_t * p){
   return p->dset_name.err + p->dset_create.err +  p->dset_delete.err + p->obj_name.err + p->obj_create.err + p->obj_read.err + p->obj_stat.err + p->obj_delete.err;
 }
@@ -263,7 +835,7 @@ static void statistics_minmax(int count, double * arr, double * out_min, double
 }
 
 static void print_p_stat(char * buff, const char * name, phase_stat_t * p, double t, int print_global){
-  const double tp = (double)(p->obj_create.suc + p->obj_read.suc) * o.file_size / t / 1024 / 1024;
+  const double tp = (double)(p->bytes_written + p->bytes_read) / t / 1024 / 1024;
 
   const int errs = sum_err(p);
   double r_min = 0;
@@ -298,16 +870,48 @@ static void print_p_stat(char * buff, const char * name, phase_stat_t * p, doubl
 
     switch(name[0]){
       case('b'):
-        pos += sprintf(buff + pos, "rate:%.1f iops/s objects:%d rate:%.1f obj/s tp:%.1f MiB/s op-max:%.4es",
-          p->obj_read.suc * ioops_per_iter / t, // write, stat, read, delete
-          p->obj_read.suc,
-          p->obj_read.suc / t,
-          tp,
-          p->max_op_time);
+        if(use_mix){
+          pos += sprintf(buff + pos, "rate:%.1f iops/s stat:%d read:%d create:%d delete:%d tp:%.1f MiB/s op-max:%.4es",
+            (p->obj_stat.suc + p->obj_read.suc + p->obj_create.suc + p->obj_delete.suc) / t,
+            p->obj_stat.suc,
+            p->obj_read.suc,
+            p->obj_create.suc,
+            p->obj_delete.suc,
+            tp,
+            p->max_op_time);
+        }else{
+          pos += sprintf(buff + pos, "rate:%.1f iops/s objects:%d rate:%.1f obj/s tp:%.1f MiB/s op-max:%.4es",
+            p->obj_read.suc * ioops_per_iter / t, // write, stat, read, delete
+            p->obj_read.suc,
+            p->obj_read.suc / t,
+            tp,
+            p->max_op_time);
+        }
 
         if(o.relative_waiting_factor > 1e-9){
           pos += sprintf(buff + pos, " waiting_factor:%.2f", o.relative_waiting_factor);
         }
+        if(o.target_rate > 0){
+          pos += sprintf(buff + pos, " missed-deadlines:%d", p->missed_deadlines);
+        }
+        if(o.cache_policy_id != CACHE_WARM){
+          pos += sprintf(buff + pos, " cache:%s", o.cache_policy);
+        }
+        break;
+      case('r'):
+        pos += sprintf(buff + pos, "rate:%.1f iops/s stat:%d read:%d create:%d delete:%d mkdir:%d rmdir:%d tp:%.1f MiB/s op-max:%.4es",
+          (p->obj_stat.suc + p->obj_read.suc + p->obj_create.suc + p->obj_delete.suc + p->dset_create.suc + p->dset_delete.suc) / t,
+          p->obj_stat.suc,
+          p->obj_read.suc,
+          p->obj_create.suc,
+          p->obj_delete.suc,
+          p->dset_create.suc,
+          p->dset_delete.suc,
+          tp,
+          p->max_op_time);
+        if(o.replay_speed > 0){
+          pos += sprintf(buff + pos, " missed-deadlines:%d", p->missed_deadlines);
+        }
         break;
       case('p'):
         pos += sprintf(buff + pos, "rate:%.1f iops/s dsets: %d objects:%d rate:%.3f dset/s rate:%.1f obj/s tp:%.1f MiB/s op-max:%.4es",
@@ -344,6 +948,18 @@ static void print_p_stat(char * buff, const char * name, phase_stat_t * p, doubl
     if(! o.quiet_output && p->stonewall_iterations){
       pos += sprintf(buff + pos, " stonewall-iter:%d", p->stonewall_iterations);
     }
+    if(! o.quiet_output && o.latency_file_prefix && ! o.latency_keep_all){
+      pos += sprintf(buff + pos, " latency-writer-blocked:%.3fs", p->writer_blocked);
+    }
+    if(o.cache_residency > 0){
+      pos += sprintf(buff + pos, " cache-resident(");
+      print_residency(buff, & pos, "before", & p->cache_before);
+      print_residency(buff, & pos, " after", & p->cache_after);
+      pos += sprintf(buff + pos, ")");
+      if(name[0] == 'b'){
+        print_residency(buff, & pos, " read-hit", & p->cache_read);
+      }
+    }
 
     if(p->stats_read.max > 1e-9){
       time_statistics_t stat = p->stats_read;
@@ -361,6 +977,23 @@ static void print_p_stat(char * buff, const char * name, phase_stat_t * p, doubl
       time_statistics_t stat = p->stats_delete;
       pos += sprintf(buff + pos, " delete(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)", stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
     }
+
+    if(p->stats_batch_read.max > 1e-9){
+      time_statistics_t stat = p->stats_batch_read;
+      pos += sprintf(buff + pos, " batch-read(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)", stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
+    }
+    if(p->stats_batch_stat.max > 1e-9){
+      time_statistics_t stat = p->stats_batch_stat;
+      pos += sprintf(buff + pos, " batch-stat(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)", stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
+    }
+    if(p->stats_batch_create.max > 1e-9){
+      time_statistics_t stat = p->stats_batch_create;
+      pos += sprintf(buff + pos, " batch-create(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)", stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
+    }
+    if(p->stats_batch_delete.max > 1e-9){
+      time_statistics_t stat = p->stats_batch_delete;
+      pos += sprintf(buff + pos, " batch-delete(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)", stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
+    }
   }
 }
 
@@ -368,9 +1001,13 @@ static int compare_floats(time_result_t * x, time_result_t * y){
   return x->runtime < y->runtime ? -1 : (x->runtime > y->runtime ? +1 : 0);
 }
 
+static uint64_t quantile_position(uint64_t repeats, float quantile){
+  uint64_t pos = round(quantile * repeats + 0.49);
+  return pos < repeats ? pos : repeats - 1;
+}
+
 static double runtime_quantile(int repeats, time_result_t * times, float quantile){
-  int pos = round(quantile * repeats + 0.49);
-  return times[pos].runtime;
+  return times[quantile_position(repeats, quantile)].runtime;
 }
 
 static uint64_t aggregate_timers(int repeats, int max_repeats, time_result_t * times, time_result_t * global_times){
@@ -426,21 +1063,81 @@ static void compute_histogram(const char * name, time_result_t * times, time_sta
   stats->max = times[repeats - 1].runtime;
 }
 
+static void compute_histogram_stats(md_histogram_t * hist, time_statistics_t * stats){
+  const uint64_t repeats = hist->count;
+  if(repeats == 0){
+    return;
+  }
+  stats->min = hist->min / 1e9;
+  stats->q1 = md_hist_value_at(hist, quantile_position(repeats, 0.25)) / 1e9;
+  if(repeats % 2 == 0){
+    stats->median = (md_hist_value_at(hist, repeats/2) + md_hist_value_at(hist, repeats/2 - 1)) / 2e9;
+  }else{
+    stats->median = md_hist_value_at(hist, repeats/2) / 1e9;
+  }
+  stats->q3 = md_hist_value_at(hist, quantile_position(repeats, 0.75)) / 1e9;
+  stats->q90 = md_hist_value_at(hist, quantile_position(repeats, 0.90)) / 1e9;
+  stats->q99 = md_hist_value_at(hist, quantile_position(repeats, 0.99)) / 1e9;
+  stats->max = hist->max / 1e9;
+}
+
+// compute the statistics of the process, from the histogram if not all individual samples have been kept, see --duration
+static void compute_process_stats(const char * name, time_result_t * times, md_histogram_t * hist, time_statistics_t * stats, size_t repeats){
+  compute_histogram(name, times, stats, repeats, 0);
+  if(hist->count > repeats){
+    compute_histogram_stats(hist, stats);
+  }
+}
+
+// the latency of whole batches is only available from the histograms
+static void compute_batch_stats(phase_stat_t * p){
+  compute_histogram_stats(p->hist_batch_create, & p->stats_batch_create);
+  compute_histogram_stats(p->hist_batch_read, & p->stats_batch_read);
+  compute_histogram_stats(p->hist_batch_stat, & p->stats_batch_stat);
+  compute_histogram_stats(p->hist_batch_delete, & p->stats_batch_delete);
+}
+
+// compute the statistics across all processes, either from the reduced histogram or from all gathered samples
+static void compute_global_stats(const char * name, phase_stat_t * p, time_result_t * times, time_result_t * g_times, md_histogram_t * g_hist, time_statistics_t * g_stats, int max_repeats, int gather_samples){
+  if(gather_samples){
+    uint64_t repeats = aggregate_timers(p->repeats, max_repeats, times, g_times);
+    if(o.rank == 0){
+      compute_histogram(name, g_times, g_stats, repeats, o.latency_keep_all);
+    }
+  }else if(o.rank == 0){
+    compute_histogram_stats(g_hist, g_stats);
+  }
+}
+
+// the latency of the stats of the objects at the depth of the tree, see --tree-depth
+static void print_depth_stat(const char * name, int depth, md_histogram_t * hist){
+  if(hist->count == 0){
+    return;
+  }
+  time_statistics_t stat;
+  compute_histogram_stats(hist, & stat);
+  printf("%s lookup depth:%d stats:%llu stat(%.4es, %.4es, %.4es, %.4es, %.4es, %.4es, %.4es)\n", name, depth, LLU hist->count, stat.min, stat.q1, stat.median, stat.q3, stat.q90, stat.q99, stat.max);
+}
+
 static void end_phase(const char * name, phase_stat_t * p){
   int ret;
   char buff[4096];
 
   char * limit_memory_P = NULL;
   MPI_Barrier(MPI_COMM_WORLD);
+  timer aggregation_timer; // the time spent in the harness to compute the report
+  start_timer(& aggregation_timer);
 
-  int max_repeats = o.precreate * o.dset_count;
-  if(strcmp(name,"benchmark") == 0){
+  int max_repeats = (strcmp(name,"cleanup") == 0 ? working_set : o.precreate) * o.dset_count;
+  if(strcmp(name,"benchmark") == 0 || strcmp(name,"replay") == 0){
     max_repeats = o.num * o.dset_count;
   }
 
+  const int gather = gather_samples();
+
   // prepare the summarized report
   phase_stat_t g_stat;
-  init_stats(& g_stat, (o.rank == 0 ? 1 : 0) * ((size_t) max_repeats) * o.size);
+  init_stats(& g_stat, (o.rank == 0 && gather ? 1 : 0) * ((size_t) max_repeats) * o.size, arena.global, arena.global_count);
   // reduce timers
   ret = MPI_Reduce(& p->t, & g_stat.t, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
   CHECK_MPI_RET(ret)
@@ -453,57 +1150,94 @@ static void end_phase(const char * name, phase_stat_t * p){
   CHECK_MPI_RET(ret)
   ret = MPI_Reduce(& p->max_op_time, & g_stat.max_op_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
   CHECK_MPI_RET(ret)
+  ret = MPI_Reduce(& p->missed_deadlines, & g_stat.missed_deadlines, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+  CHECK_MPI_RET(ret)
+  ret = MPI_Reduce(& p->writer_blocked, & g_stat.writer_blocked, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  CHECK_MPI_RET(ret)
+  ret = MPI_Reduce(& p->bytes_written, & g_stat.bytes_written, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+  CHECK_MPI_RET(ret)
+  ret = MPI_Reduce(& p->cache_before, & g_stat.cache_before, 3 * 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+  CHECK_MPI_RET(ret)
+  if(o.cpu_time){
+    ret = MPI_Reduce(p->cpu_op, g_stat.cpu_op, 4 + 4 + 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    CHECK_MPI_RET(ret)
+    ret = MPI_Reduce(p->cpu_op_count, g_stat.cpu_op_count, 4, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    CHECK_MPI_RET(ret)
+  }
+  if(o.perf_counters){
+    ret = MPI_Reduce(p->perf_phase, g_stat.perf_phase, 6 * MD_PC_COUNT + 4, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    CHECK_MPI_RET(ret)
+  }
   if( p->stonewall_iterations ){
     ret = MPI_Reduce(& p->repeats, & g_stat.repeats, 1, MPI_UINT64_T, MPI_MIN, 0, MPI_COMM_WORLD);
     CHECK_MPI_RET(ret)
     g_stat.stonewall_iterations = p->stonewall_iterations;
   }
-  int write_rank0_latency_file = (o.rank == 0) && ! o.latency_keep_all;
+  ret = MPI_Reduce(p->hist_create, g_stat.hist_create, HIST_COUNT, hist_type, hist_op, 0, MPI_COMM_WORLD);
+  CHECK_MPI_RET(ret)
+  if(o.tree_depth > 0){
+    ret = MPI_Reduce(p->hist_depth, g_stat.hist_depth, o.tree_depth + 1, hist_type, hist_op, 0, MPI_COMM_WORLD);
+    CHECK_MPI_RET(ret)
+  }
+  if(o.trace_prefix){
+    write_trace(name, p);
+  }
+  // the latency files of the process have been streamed during the phase, see run_phase()
 
   if(strcmp(name,"precreate") == 0){
-    uint64_t repeats = aggregate_timers(p->repeats, max_repeats, p->time_create, g_stat.time_create);
-    if(o.rank == 0){
-      compute_histogram("precreate-all", g_stat.time_create, & g_stat.stats_create, repeats, o.latency_keep_all);
-    }
-    compute_histogram("precreate", p->time_create, & p->stats_create, p->repeats, write_rank0_latency_file);
+    compute_global_stats("precreate-all", p, p->time_create, g_stat.time_create, g_stat.hist_create, & g_stat.stats_create, max_repeats, gather);
+    compute_histogram("precreate", p->time_create, & p->stats_create, p->repeats, 0);
   }else if(strcmp(name,"cleanup") == 0){
-    uint64_t repeats = aggregate_timers(p->repeats, max_repeats, p->time_delete, g_stat.time_delete);
-    if(o.rank == 0) {
-      compute_histogram("cleanup-all", g_stat.time_delete, & g_stat.stats_delete, repeats, o.latency_keep_all);
-    }
-    compute_histogram("cleanup", p->time_delete, & p->stats_delete, p->repeats, write_rank0_latency_file);
-  }else if(strcmp(name,"benchmark") == 0){
-    uint64_t repeats = aggregate_timers(p->repeats, max_repeats, p->time_read, g_stat.time_read);
-    if(o.rank == 0) {
-      compute_histogram("read-all", g_stat.time_read, & g_stat.stats_read, repeats, o.latency_keep_all);
-    }
-    compute_histogram("read", p->time_read, & p->stats_read, p->repeats, write_rank0_latency_file);
+    compute_global_stats("cleanup-all", p, p->time_delete, g_stat.time_delete, g_stat.hist_delete, & g_stat.stats_delete, max_repeats, gather);
+    compute_histogram("cleanup", p->time_delete, & p->stats_delete, p->repeats, 0);
+  }else if(strcmp(name,"benchmark") == 0 || strcmp(name,"replay") == 0){
+    compute_global_stats("read-all", p, p->time_read, g_stat.time_read, g_stat.hist_read, & g_stat.stats_read, max_repeats, gather);
+    compute_process_stats("read", p->time_read, p->hist_read, & p->stats_read, p->repeats);
 
-    repeats = aggregate_timers(p->repeats, max_repeats, p->time_stat, g_stat.time_stat);
-    if(o.rank == 0) {
-      compute_histogram("stat-all", g_stat.time_stat, & g_stat.stats_stat, repeats, o.latency_keep_all);
-    }
-    compute_histogram("stat", p->time_stat, & p->stats_stat, p->repeats, write_rank0_latency_file);
+    compute_global_stats("stat-all", p, p->time_stat, g_stat.time_stat, g_stat.hist_stat, & g_stat.stats_stat, max_repeats, gather);
+    compute_process_stats("stat", p->time_stat, p->hist_stat, & p->stats_stat, p->repeats);
 
     if(! o.read_only){
-      repeats = aggregate_timers(p->repeats, max_repeats, p->time_create, g_stat.time_create);
-      if(o.rank == 0) {
-        compute_histogram("create-all", g_stat.time_create, & g_stat.stats_create, repeats, o.latency_keep_all);
-      }
-      compute_histogram("create", p->time_create, & p->stats_create, p->repeats, write_rank0_latency_file);
+      compute_global_stats("create-all", p, p->time_create, g_stat.time_create, g_stat.hist_create, & g_stat.stats_create, max_repeats, gather);
+      compute_process_stats("create", p->time_create, p->hist_create, & p->stats_create, p->repeats);
 
-      repeats = aggregate_timers(p->repeats, max_repeats, p->time_delete, g_stat.time_delete);
-      if(o.rank == 0) {
-        compute_histogram("delete-all", g_stat.time_delete, & g_stat.stats_delete, repeats, o.latency_keep_all);
-      }
-      compute_histogram("delete", p->time_delete, & p->stats_delete, p->repeats, write_rank0_latency_file);
+      compute_global_stats("delete-all", p, p->time_delete, g_stat.time_delete, g_stat.hist_delete, & g_stat.stats_delete, max_repeats, gather);
+      compute_process_stats("delete", p->time_delete, p->hist_delete, & p->stats_delete, p->repeats);
     }
   }
+  compute_batch_stats(p);
+  if (o.rank == 0){
+    compute_batch_stats(& g_stat);
+  }
+
+  const double aggregation_time = stop_timer(aggregation_timer);
 
   if (o.rank == 0){
     //print the stats:
     print_p_stat(buff, name, & g_stat, g_stat.t, 1);
     printf("%s\n", buff);
+    if(o.verbosity){
+      printf("%s aggregation:%.6fs\n", name, aggregation_time);
+    }
+    if(o.cpu_time){
+      print_cpu_time(name, & g_stat);
+    }
+    for(int i=0; g_stat.hist_depth && i <= o.tree_depth; i++){
+      print_depth_stat(name, i, depth_hist(g_stat.hist_depth, i));
+    }
+    if(o.perf_counters){
+      // the average per operation of all processes
+      op_stat_t * ops[] = {& g_stat.dset_create, & g_stat.dset_delete, & g_stat.obj_create, & g_stat.obj_read, & g_stat.obj_stat, & g_stat.obj_delete};
+      uint64_t count = 0;
+      for(int i=0; i < 6; i++){
+        count += ops[i]->suc + ops[i]->err;
+      }
+      print_perf(name, "per-op", g_stat.perf_phase, count, g_stat.perf_multiplexed);
+      const char * op_names[] = {"create", "read", "stat", "delete"};
+      for(int t=0; t < 4; t++){
+        print_perf(name, op_names[t], g_stat.perf_ops[t], g_stat.perf_op_count[t], g_stat.perf_multiplexed);
+      }
+    }
   }
 
   if(o.process_report){
@@ -523,18 +1257,11 @@ static void end_phase(const char * name, phase_stat_t * p){
   if(g_stat.t_all){
     free(g_stat.t_all);
   }
-  if(p->time_create){
-    free(p->time_create);
-    free(p->time_read);
-    free(p->time_stat);
-    free(p->time_delete);
-  }
-  if(g_stat.time_create){
-    free(g_stat.time_create);
-    free(g_stat.time_read);
-    free(g_stat.time_stat);
-    free(g_stat.time_delete);
-  }
+  free(p->hist_create);
+  free(g_stat.hist_create);
+  free(p->hist_depth);
+  free(g_stat.hist_depth);
+  free(p->trace);
 
   // allocate if necessary
   ret = mem_preallocate(& limit_memory_P, o.limit_memory_between_phases, o.verbosity >= 3);
@@ -544,212 +1271,899 @@ static void end_phase(const char * name, phase_stat_t * p){
   mem_free_preallocated(& limit_memory_P);
 }
 
-void run_precreate(phase_stat_t * s, int current_index){
-  char dset[4096];
-  char obj_name[4096];
-  int ret;
+static pthread_barrier_t thread_barrier;
 
-  for(int i=0; i < o.dset_count; i++){
-    ret = o.plugin->def_dset_name(dset, o.rank, i);
-    if (ret != MD_SUCCESS){
-      if (! o.ignore_precreate_errors){
-        printf("Error defining the dataset name\n");
-        MPI_Abort(MPI_COMM_WORLD, 1);
-      }
-      s->dset_name.err++;
-      continue;
-    }
-    s->dset_name.suc++;
-    ret = o.plugin->create_dset(dset);
-    if (ret == MD_NOOP){
-      // do not increment any counter
-    }else if (ret == MD_SUCCESS){
-      s->dset_create.suc++;
-    }else{
-      s->dset_create.err++;
-      if (! o.ignore_precreate_errors){
-        printf("%d: Error while creating the dset: %s\n", o.rank, dset);
-        MPI_Abort(MPI_COMM_WORLD, 1);
-      }
-    }
+// synchronize the threads of this process
+static void wait_for_threads(){
+  if(o.threads > 1){
+    pthread_barrier_wait(& thread_barrier);
   }
+}
 
-  char * buf = malloc(o.file_size);
-  memset(buf, o.rank % 256, o.file_size);
-  timer op_timer; // timer for individual operations
-  size_t pos = -1; // position inside the individual measurement array
-  double op_time;
+// an object of a batch and the position of its measurements
+typedef struct{
+  size_t pos;
+  int f;
+  int d;
+  int obj_rank; // the owner and index of the object for the trace
+  int obj;
+} batch_item_t;
 
-  // create the obj
-  for(int f=current_index; f < o.precreate; f++){
-    for(int d=0; d < o.dset_count; d++){
-      ret = o.plugin->def_dset_name(dset, o.rank, d);
-      pos++;
-      ret = o.plugin->def_obj_name(obj_name, o.rank, d, f);
-      if (ret != MD_SUCCESS){
-        s->dset_name.err++;
-        if (! o.ignore_precreate_errors){
-          printf("%d: Error while creating the obj name\n", o.rank);
-          fflush(stdout);
-          MPI_Abort(MPI_COMM_WORLD, 1);
-        }
-        s->obj_name.err++;
-        continue;
-      }
+// a batch of objects processed together, see --batch
+typedef struct{
+  int count;
+  md_obj_t * objs;
+  batch_item_t * items;
+  char * names; // storage for the dataset and object names of each object
+} batch_t;
+
+static void batch_init(batch_t * b, char * buf){
+  b->count = 0;
+  b->objs = malloc(sizeof(md_obj_t) * o.batch);
+  b->items = malloc(sizeof(batch_item_t) * o.batch);
+  b->names = malloc(2 * 4096 * (size_t) o.batch);
+  for(int i=0; i < o.batch; i++){
+    b->objs[i].dset = b->names + 2 * 4096 * (size_t) i;
+    b->objs[i].name = b->objs[i].dset + 4096;
+    b->objs[i].buf = buf;
+  }
+}
 
-      start_timer(& op_timer);
-      ret = o.plugin->write_obj(dset, obj_name, buf, o.file_size);
-      add_timed_result(op_timer, s->phase_start_timer, s->time_create, pos, & s->max_op_time, & op_time);
+static void batch_free(batch_t * b){
+  free(b->names);
+  free(b->items);
+  free(b->objs);
+}
 
-      if (o.verbosity >= 2){
-        printf("%d: write %s:%s (%d)\n", o.rank, dset, obj_name, ret);
-      }
+// append an object to the batch, the caller fills in the names
+static md_obj_t * batch_add(batch_t * b, size_t pos, int f, int d){
+  batch_item_t * item = & b->items[b->count];
+  item->pos = pos;
+  item->f = f;
+  item->d = d;
+  item->obj_rank = o.rank;
+  item->obj = f;
+  return & b->objs[b->count++];
+}
 
-      if (ret == MD_NOOP){
-        // do not increment any counter
-      }else if (ret == MD_SUCCESS){
-        s->obj_create.suc++;
-      }else{
-        s->obj_create.err++;
-        if (! o.ignore_precreate_errors){
-          printf("%d: Error while creating the obj: %s\n", o.rank, obj_name);
-          fflush(stdout);
-          MPI_Abort(MPI_COMM_WORLD, 1);
-        }
+// keep only the object at position i, objects must be kept in increasing order
+static void batch_keep(batch_t * b, int i, int * kept){
+  if(i != *kept){
+    char * dset = b->objs[*kept].dset;
+    char * name = b->objs[*kept].name;
+    strcpy(dset, b->objs[i].dset);
+    strcpy(name, b->objs[i].name);
+    b->objs[*kept].ret = b->objs[i].ret;
+    b->items[*kept] = b->items[i];
+  }
+  (*kept)++;
+}
+
+/* Run the operation on all objects of the batch, with the batched function of the plugin if available.
+   The runtime of the batch is accounted as amortized latency for each object and as latency of the batch. */
+static void batch_run(phase_stat_t * s, batch_t * b, md_op_type type){
+  time_result_t * times = NULL;
+  md_histogram_t * hist = NULL;
+  md_histogram_t * batch_hist = NULL;
+  int (*batch_op)(md_obj_t * objs, int count) = NULL;
+  switch(type){
+    case(MD_OP_WRITE):
+      times = s->time_create;
+      hist = s->hist_create;
+      batch_hist = s->hist_batch_create;
+      batch_op = o.plugin->write_objs;
+      break;
+    case(MD_OP_READ):
+      times = s->time_read;
+      hist = s->hist_read;
+      batch_hist = s->hist_batch_read;
+      batch_op = o.plugin->read_objs;
+      break;
+    case(MD_OP_STAT):
+      times = s->time_stat;
+      hist = s->hist_stat;
+      batch_hist = s->hist_batch_stat;
+      batch_op = o.plugin->stat_objs;
+      break;
+    case(MD_OP_DELETE):
+      times = s->time_delete;
+      hist = s->hist_delete;
+      batch_hist = s->hist_batch_delete;
+      batch_op = o.plugin->delete_objs;
+      break;
+  }
+  if(b->count == 0){
+    return;
+  }
+  for(int i=0; i < b->count; i++){
+    b->objs[i].size = obj_size(b->items[i].obj_rank, b->items[i].d, b->items[i].obj);
+  }
+
+  timer op_timer;
+  start_op_cpu(s);
+  start_timer(& op_timer);
+  if(batch_op){
+    int ret = batch_op(b->objs, b->count);
+    for(int i=0; ret != MD_SUCCESS && i < b->count; i++){
+      b->objs[i].ret = ret;
+    }
+  }else{
+    for(int i=0; i < b->count; i++){
+      md_obj_t * obj = & b->objs[i];
+      switch(type){
+        case(MD_OP_WRITE):
+          obj->ret = o.plugin->write_obj(obj->dset, obj->name, obj->buf, obj->size);
+          break;
+        case(MD_OP_READ):
+          obj->ret = o.plugin->read_obj(obj->dset, obj->name, obj->buf, obj->size);
+          break;
+        case(MD_OP_STAT):
+          obj->ret = o.plugin->stat_obj(obj->dset, obj->name, obj->size);
+          break;
+        case(MD_OP_DELETE):
+          obj->ret = o.plugin->delete_obj(obj->dset, obj->name);
+          break;
       }
     }
   }
-  free(buf);
+  const uint64_t batch_ns = op_latency_ns(op_timer);
+  const float curtime = timer_subtract(op_timer, s->phase_start_timer);
+  const double batch_time = batch_ns * 1e-9;
+  const double op_time = batch_time / b->count;
+  for(int i=0; i < b->count; i++){
+    time_result_t * result = & times[b->items[i].pos];
+    result->runtime = (float) op_time;
+    result->time_since_app_start = curtime;
+    record_op(s, type, op_timer, batch_ns / b->count, b->items[i].obj_rank, b->items[i].d, b->items[i].obj, b->objs[i].size, b->objs[i].ret);
+    md_hist_add(hist, batch_ns / b->count);
+    if(interval_report){
+      md_interval_add(interval_report, batch_ns / b->count);
+    }
+  }
+  if(interval_report){
+    md_interval_progress(interval_report);
+  }
+  md_hist_add(batch_hist, batch_ns);
+  if (batch_time > s->max_op_time){
+    s->max_op_time = batch_time;
+  }
+  if(o.relative_waiting_factor > 1e-9) {
+    wait(batch_time);
+  }
+}
+
+static void precreate_write_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (o.verbosity >= 2){
+    printf("%d: write %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+  }
+
+  if (ret == MD_NOOP){
+    // do not increment any counter
+  }else if (ret == MD_SUCCESS){
+    s->obj_create.suc++;
+  }else{
+    s->obj_create.err++;
+    if (! o.ignore_precreate_errors){
+      printf("%d: Error while creating the obj: %s\n", o.rank, obj_name);
+      fflush(stdout);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+}
+
+static void cleanup_delete_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (o.verbosity >= 2){
+    printf("%d: delete %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+  }
+
+  if (ret == MD_NOOP){
+    // nothing to do
+  }else if (ret == MD_SUCCESS){
+    s->obj_delete.suc++;
+  }else if(ret != MD_NOOP){
+    s->obj_delete.err++;
+  }
 }
 
-/* FIFO: create a new file, write to it. Then read from the first created file, delete it... */
-void run_benchmark(phase_stat_t * s, int * current_index_p){
+static void precreate_write_batch(phase_stat_t * s, batch_t * b){
+  batch_run(s, b, MD_OP_WRITE);
+  for(int i=0; i < b->count; i++){
+    precreate_write_done(s, b->objs[i].ret, b->objs[i].dset, b->objs[i].name);
+  }
+  b->count = 0;
+}
+
+static void cleanup_delete_batch(phase_stat_t * s, batch_t * b){
+  batch_run(s, b, MD_OP_DELETE);
+  for(int i=0; i < b->count; i++){
+    cleanup_delete_done(s, b->objs[i].ret, b->objs[i].dset, b->objs[i].name);
+  }
+  b->count = 0;
+}
+
+static void precreate_dset(phase_stat_t * s, char * dset){
+  const int ret = o.plugin->create_dset(dset);
+  if (ret == MD_NOOP){
+    // do not increment any counter
+  }else if (ret == MD_SUCCESS){
+    s->dset_create.suc++;
+  }else{
+    s->dset_create.err++;
+    if (! o.ignore_precreate_errors){
+      printf("%d: Error while creating the dset: %s\n", o.rank, dset);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+}
+
+void run_precreate(phase_stat_t * s, int current_index, int thread){
   char dset[4096];
   char obj_name[4096];
   int ret;
-  char * buf = malloc(o.file_size);
-  memset(buf, o.rank % 256, o.file_size);
+
+  const int owner = o.rank == shared_leader(o.rank);
+  for(int i=thread; owner && i < o.dset_count; i += o.threads){
+    ret = define_dset_name(dset, o.rank, i);
+    if (ret != MD_SUCCESS){
+      if (! o.ignore_precreate_errors){
+        printf("Error defining the dataset name\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+      s->dset_name.err++;
+      continue;
+    }
+    s->dset_name.suc++;
+    precreate_dset(s, dset);
+  }
+  wait_for_threads();
+
+  // the directories of the trees level by level, thus, the parents exist, see --tree-depth
+  for(int depth=1; depth <= o.tree_depth; depth++){
+    const int width = tree_first[depth + 1] - tree_first[depth];
+    for(int i=thread; owner && i < o.dset_count * width; i += o.threads){
+      tree_node_name(dset, o.rank, i / width, tree_first[depth] + i % width);
+      precreate_dset(s, dset);
+    }
+    wait_for_threads();
+  }
+  if(o.shared_dsets > 1){
+    // the members of the group create their objects once the leader created the data sets
+    MPI_Barrier(shared_comm);
+  }
+
+  char * buf = malloc(md_size_dist_max(& size_dist));
+  memset(buf, o.rank % 256, md_size_dist_max(& size_dist));
   timer op_timer; // timer for individual operations
   size_t pos = -1; // position inside the individual measurement array
-  int start_index = *current_index_p;
-  int total_num = o.num;
-  int armed_stone_wall = (o.stonewall_timer > 0);
-  int f;
-  double phase_allreduce_time = 0;
+  uint64_t op_ns;
+  batch_t batch;
+  if(o.batch > 1){
+    batch_init(& batch, buf);
+  }
 
-  for(f=0; f < total_num; f++){
-    float bench_runtime = 0; // the time since start
+  // create the obj
+  for(int f=current_index + thread; f < o.precreate; f += o.threads){
     for(int d=0; d < o.dset_count; d++){
-      double op_time;
-      const int prevFile = f + start_index;
-      pos++;
-
-      int readRank = (o.rank - o.offset * (d+1)) % o.size;
-      readRank = readRank < 0 ? readRank + o.size : readRank;
-      ret = o.plugin->def_obj_name(obj_name, readRank, d, prevFile);
+      if(o.batch > 1){
+        md_obj_t * obj = batch_add(& batch, ++pos, f, d);
+        define_dset_name(obj->dset, o.rank, d);
+        ret = define_obj_name(obj->name, o.rank, d, f);
+        if (ret != MD_SUCCESS){
+          batch.count--;
+        }
+      }else{
+        ret = define_dset_name(dset, o.rank, d);
+        pos++;
+        ret = define_obj_name(obj_name, o.rank, d, f);
+      }
       if (ret != MD_SUCCESS){
+        s->dset_name.err++;
+        if (! o.ignore_precreate_errors){
+          printf("%d: Error while creating the obj name\n", o.rank);
+          fflush(stdout);
+          MPI_Abort(MPI_COMM_WORLD, 1);
+        }
         s->obj_name.err++;
         continue;
       }
-      ret = o.plugin->def_dset_name(dset, readRank, d);
 
-      start_timer(& op_timer);
-      ret = o.plugin->stat_obj(dset, obj_name, o.file_size);
-      bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_stat, pos, & s->max_op_time, & op_time);
-      if(o.relative_waiting_factor > 1e-9) {
-        wait(op_time);
+      if(o.batch > 1){
+        if(batch.count == o.batch){
+          precreate_write_batch(s, & batch);
+        }
+        continue;
       }
 
-      if (o.verbosity >= 2){
-        printf("%d: stat %s:%s (%d)\n", o.rank, dset, obj_name, ret);
-      }
+      const size_t size = obj_size(o.rank, d, f);
+      start_op_cpu(s);
+      start_timer(& op_timer);
+      ret = o.plugin->write_obj(dset, obj_name, buf, size);
+      add_timed_result(op_timer, s->phase_start_timer, s->time_create, s->hist_create, pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_WRITE, op_timer, op_ns, o.rank, d, f, size, ret);
+      precreate_write_done(s, ret, dset, obj_name);
+    }
+  }
+  if(o.batch > 1){
+    precreate_write_batch(s, & batch);
+    batch_free(& batch);
+  }
+  s->repeats = pos + 1;
+  free(buf);
+}
 
-      if(ret != MD_SUCCESS && ret != MD_NOOP){
-        if (o.verbosity)
-          printf("%d: Error while stating the obj: %s\n", o.rank, dset);
-        s->obj_stat.err++;
-        continue;
-      }
-      s->obj_stat.suc++;
+// the process owning the objects read by the benchmark from dataset d
+static int bench_read_rank(int d){
+  int readRank = (o.rank - o.offset * (d+1)) % o.size;
+  return readRank < 0 ? readRank + o.size : readRank;
+}
 
-      if (o.verbosity >= 2){
-        printf("%d: read %s:%s \n", o.rank, dset, obj_name);
-      }
+// the process owning the objects created by the benchmark in dataset d
+static int bench_write_rank(int d){
+  return (o.rank + o.offset * (d+1)) % o.size;
+}
 
-      start_timer(& op_timer);
-      ret = o.plugin->read_obj(dset, obj_name, buf, o.file_size);
-      bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_read, pos, & s->max_op_time, & op_time);
-      if(o.relative_waiting_factor > 1e-9) {
-        wait(op_time);
+// the object read (and deleted) by the benchmark in iteration f
+static int bench_read_obj_name(char * dset, char * obj_name, int f, int d, int start_index){
+  int readRank = bench_read_rank(d);
+  int ret = define_obj_name(obj_name, readRank, d, f + start_index);
+  if (ret != MD_SUCCESS){
+    return ret;
+  }
+  return define_dset_name(dset, readRank, d);
+}
+
+// the object newly created by the benchmark in iteration f
+static int bench_write_obj_name(char * dset, char * obj_name, int f, int d, int start_index){
+  int writeRank = bench_write_rank(d);
+  int ret = define_obj_name(obj_name, writeRank, d, o.precreate + f + start_index);
+  if (ret != MD_SUCCESS){
+    return ret;
+  }
+  return define_dset_name(dset, writeRank, d);
+}
+
+/* The objects read by a benchmark iteration are count objects of the reading rank starting with the returned index.
+   With --mix, the oldest objects are deleted and the remaining ones are read, see schedule_build_mix(). */
+static int bench_read_range(int start_index, int * count){
+  if(! use_mix){
+    *count = o.num;
+    return start_index;
+  }
+  const int deleted = mix.count[MD_OP_DELETE] * o.num;
+  *count = working_set - deleted;
+  return start_index + deleted;
+}
+
+/* Evict the objects read by the next benchmark iteration from the caches, before its timer is started.
+   With evict each process asks the plugin to evict its objects, with drop one process per node drops
+   the page cache, dentries and inodes of the node. */
+static void evict_cache(int start_index){
+  if(o.cache_policy_id == CACHE_WARM){
+    return;
+  }
+  timer start;
+  start_timer(& start);
+  int errors = 0;
+  if(o.cache_policy_id == CACHE_EVICT){
+    char dset[4096];
+    char obj_name[4096];
+    int count;
+    const int first = bench_read_range(start_index, & count);
+    for(int f=0; f < count; f++){
+      for(int d=0; d < o.dset_count; d++){
+        if(bench_read_obj_name(dset, obj_name, f, d, first) != MD_SUCCESS || o.plugin->evict_obj(dset, obj_name) != MD_SUCCESS){
+          errors++;
+        }
       }
+    }
+  }else if(node_rank == 0){
+    sync();
+    FILE * f = fopen("/proc/sys/vm/drop_caches", "w");
+    if(f == NULL || fprintf(f, "3\n") < 0){
+      errors++;
+    }
+    if(f){
+      fclose(f);
+    }
+  }
+  int total_errors;
+  MPI_Reduce(& errors, & total_errors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+  if(o.rank == 0 && (total_errors > 0 || o.verbosity)){
+    printf("Cache eviction (%s): %.3fs errors:%d\n", o.cache_policy, stop_timer(start), total_errors);
+  }
+}
 
-      if (ret == MD_SUCCESS){
-        s->obj_read.suc++;
-      }else if (ret == MD_NOOP){
-        // nothing to do
-      }else if (ret == MD_ERROR_FIND){
-        printf("%d: Error while accessing the file %s (%s)\n", o.rank, dset, strerror(errno));
-        s->obj_read.err++;
-      }else{
-        printf("%d: Error while reading the file %s (%s)\n", o.rank, dset, strerror(errno));
-        s->obj_read.err++;
+/* Sample which pages of the objects are in the cache of the client, without the time being part of the phase.
+   Every k-th object is sampled where k is derived from the fraction of --cache-residency, the mapping of
+   an object is not accessed and does not change the cache. */
+static int residency_stride(){
+  int k = (int) (1.0 / o.cache_residency + 0.5);
+  return k < 1 ? 1 : k;
+}
+
+static void add_residency(residency_t * r, char * dset, char * obj_name){
+  uint64_t resident;
+  uint64_t pages;
+  if(o.plugin->obj_residency(dset, obj_name, & resident, & pages) == MD_SUCCESS){
+    r->resident += resident;
+    r->pages += pages;
+  }
+}
+
+// the working set of the objects owned by the process
+static void sample_residency(residency_t * r, int start_index){
+  if(o.cache_residency <= 0){
+    return;
+  }
+  char dset[4096];
+  char obj_name[4096];
+  const int k = residency_stride();
+  for(int d=0; d < o.dset_count; d++){
+    if(define_dset_name(dset, o.rank, d) != MD_SUCCESS){
+      continue;
+    }
+    for(int f=0; f < working_set; f += k){
+      if(define_obj_name(obj_name, o.rank, d, f + start_index) == MD_SUCCESS){
+        add_residency(r, dset, obj_name);
       }
+    }
+  }
+}
 
-      if(o.read_only){
-        continue;
+// the objects the next benchmark iteration of the process reads, i.e., the expected cache hits
+static void sample_read_residency(residency_t * r, int start_index){
+  if(o.cache_residency <= 0){
+    return;
+  }
+  char dset[4096];
+  char obj_name[4096];
+  const int k = residency_stride();
+  int count;
+  const int first = bench_read_range(start_index, & count);
+  for(int f=0; f < count; f += k){
+    for(int d=0; d < o.dset_count; d++){
+      if(bench_read_obj_name(dset, obj_name, f, d, first) == MD_SUCCESS){
+        add_residency(r, dset, obj_name);
       }
+    }
+  }
+}
 
-      start_timer(& op_timer);
-      ret = o.plugin->delete_obj(dset, obj_name);
-      bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_delete, pos, & s->max_op_time, & op_time);
-      if(o.relative_waiting_factor > 1e-9) {
-        wait(op_time);
+// a precomputed operation of the benchmark, see run_benchmark()
+typedef struct{
+  int64_t obj; // the index of the object
+  int obj_rank; // the owner of the object
+  int dset;
+  uint32_t dset_name; // offset into the name arena
+  uint32_t obj_name; // offset into the name arena or SCHED_NO_NAME
+  uint32_t size; // the size of the object
+  uint8_t type; // md_op_type
+} sched_op_t;
+
+#define SCHED_NO_NAME UINT32_MAX
+// the maximum number of objects in a window of the schedule, bounds the memory of the schedule
+#define SCHED_WINDOW_OBJECTS (256 * 1024)
+
+/* The schedule of a thread for a window of iterations, all operations of an object are consecutive.
+   The names are stored in an arena, the dataset names at its beginning are kept for all windows. */
+typedef struct{
+  sched_op_t * ops;
+  int ops_per_obj;
+  int ops_per_iteration;
+  int first; // the first iteration of the window
+  int end; // the first iteration after the window
+  int start_index;
+  int capacity; // the maximum number of iterations of a window
+  uint32_t * dset_names; // the dataset names of the read and written objects for each dataset
+  char * names;
+  size_t names_used;
+  size_t names_capacity;
+  size_t dset_names_used;
+} schedule_t;
+
+// the schedules of the threads, prepared before the benchmark phase
+static schedule_t * schedules = NULL;
+
+static uint32_t schedule_add_name(schedule_t * sc, const char * name){
+  const size_t len = strlen(name) + 1;
+  if(sc->names_used + len > sc->names_capacity){
+    sc->names_capacity = sc->names_capacity * 2 > sc->names_used + len ? sc->names_capacity * 2 : sc->names_used + len + 4096;
+    sc->names = realloc(sc->names, sc->names_capacity);
+  }
+  memcpy(sc->names + sc->names_used, name, len);
+  const uint32_t offset = (uint32_t) sc->names_used;
+  sc->names_used += len;
+  return offset;
+}
+
+static uint32_t schedule_obj_name(schedule_t * sc, uint32_t dset_name, int rank, int d, int64_t obj){
+  char name[4096];
+  if(dset_name == SCHED_NO_NAME || define_obj_name(name, rank, d, obj) != MD_SUCCESS){
+    return SCHED_NO_NAME;
+  }
+  return schedule_add_name(sc, name);
+}
+
+static void schedule_init(schedule_t * sc, int thread){
+  memset(sc, 0, sizeof(schedule_t));
+  // with --mix the operations of an iteration access different objects
+  sc->ops_per_obj = use_mix ? 1 : (o.read_only ? 2 : 4);
+  sc->ops_per_iteration = (use_mix ? mix.ops : sc->ops_per_obj) * o.dset_count;
+  const int iterations = (o.num - thread + o.threads - 1) / o.threads;
+  sc->capacity = SCHED_WINDOW_OBJECTS * sc->ops_per_obj / sc->ops_per_iteration;
+  if(sc->capacity < 1){
+    sc->capacity = 1;
+  }
+  if(! o.duration && iterations < sc->capacity){
+    sc->capacity = iterations > 0 ? iterations : 1;
+  }
+  sc->ops = malloc(sizeof(sched_op_t) * sc->ops_per_iteration * (size_t) sc->capacity);
+  sc->dset_names = malloc(sizeof(uint32_t) * 2 * o.dset_count);
+  char name[4096];
+  for(int d=0; d < o.dset_count; d++){
+    const int ranks[] = {bench_read_rank(d), bench_write_rank(d)};
+    for(int i=0; i < 2; i++){
+      int ret = define_dset_name(name, ranks[i], d);
+      sc->dset_names[2 * d + i] = ret == MD_SUCCESS ? schedule_add_name(sc, name) : SCHED_NO_NAME;
+    }
+  }
+  sc->dset_names_used = sc->names_used;
+}
+
+static void schedule_free(schedule_t * sc){
+  free(sc->ops);
+  free(sc->dset_names);
+  free(sc->names);
+}
+
+/* The iterations with --mix: iteration f deletes the oldest objects of the reading rank, i.e., the objects
+   following the ones deleted by the previous iterations, and creates objects after the working set of the writing rank.
+   The stats and reads select among the objects of the reading rank that are not deleted by the phase,
+   thus, the iterations are independent of each other and of the threads executing them. */
+static void schedule_build_mix(schedule_t * sc, int first, int total_num){
+  uint8_t * types = malloc(mix.ops);
+  int read_count;
+  const int read_first = bench_read_range(sc->start_index, & read_count);
+  sc->names_used = sc->dset_names_used;
+  sched_op_t * op = sc->ops;
+  int64_t f = first;
+  for(int i=0; i < sc->capacity && f < total_num; i++, f += o.threads){
+    for(int d=0; d < o.dset_count; d++){
+      int j[4] = {0, 0, 0, 0}; // the operations of each type within the iteration
+      md_mix_iteration(& mix, f, d, types);
+      for(int k=0; k < mix.ops; k++){
+        const md_op_type type = (md_op_type) types[k];
+        op->type = type;
+        op->dset = d;
+        if(type == MD_OP_WRITE){
+          op->obj_rank = bench_write_rank(d);
+          op->obj = sc->start_index + working_set + f * mix.count[MD_OP_WRITE] + j[type];
+          op->dset_name = sc->dset_names[2 * d + 1];
+        }else{
+          op->obj_rank = bench_read_rank(d);
+          if(type == MD_OP_DELETE){
+            op->obj = sc->start_index + f * mix.count[MD_OP_DELETE] + j[type];
+          }else{
+            op->obj = read_first + md_mix_select_obj(& mix, type, f, d, j[type], read_count);
+          }
+          op->dset_name = sc->dset_names[2 * d];
+        }
+        op->obj_name = schedule_obj_name(sc, op->dset_name, op->obj_rank, d, op->obj);
+        op->size = (uint32_t) obj_size(op->obj_rank, d, op->obj);
+        j[type]++;
+        op++;
       }
+    }
+  }
+  free(types);
+  sc->first = first;
+  sc->end = f < INT_MAX ? (int) f : INT_MAX;
+}
 
-      if (o.verbosity >= 2){
-        printf("%d: delete %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+// compute the operations of the iterations starting with first, the iterations of a thread are first, first + threads, ...
+static void schedule_build(schedule_t * sc, int first, int total_num){
+  if(use_mix){
+    schedule_build_mix(sc, first, total_num);
+    return;
+  }
+  const md_op_type types[] = {MD_OP_STAT, MD_OP_READ, MD_OP_DELETE, MD_OP_WRITE};
+  sc->names_used = sc->dset_names_used;
+  sched_op_t * op = sc->ops;
+  int64_t f = first;
+  for(int i=0; i < sc->capacity && f < total_num; i++, f += o.threads){
+    for(int d=0; d < o.dset_count; d++){
+      const int read_rank = bench_read_rank(d);
+      const uint32_t read_dset = sc->dset_names[2 * d];
+      const uint32_t read_name = schedule_obj_name(sc, read_dset, read_rank, d, f + sc->start_index);
+      for(int t=0; t < sc->ops_per_obj; t++){
+        op->type = types[t];
+        op->dset = d;
+        if(types[t] == MD_OP_WRITE){
+          op->obj_rank = bench_write_rank(d);
+          op->obj = o.precreate + f + sc->start_index;
+          op->dset_name = sc->dset_names[2 * d + 1];
+          op->obj_name = schedule_obj_name(sc, op->dset_name, op->obj_rank, d, op->obj);
+        }else{
+          op->obj_rank = read_rank;
+          op->obj = f + sc->start_index;
+          op->dset_name = read_dset;
+          op->obj_name = read_name;
+        }
+        op->size = (uint32_t) obj_size(op->obj_rank, d, op->obj);
+        op++;
       }
+    }
+  }
+  sc->first = first;
+  sc->end = f < INT_MAX ? (int) f : INT_MAX;
+}
 
-      if (ret == MD_SUCCESS){
-        s->obj_delete.suc++;
-      }else if (ret == MD_NOOP){
-        // nothing to do
-      }else{
-        printf("%d: Error while deleting the object %s:%s\n", o.rank, dset, obj_name);
-        s->obj_delete.err++;
+// prepare the schedules of the next benchmark iteration before its timer is started
+static void prepare_benchmark(int start_index){
+  if((o.queue_depth > 1 && o.plugin->submit_op) || o.batch > 1){
+    return;
+  }
+  if(schedules == NULL){
+    schedules = malloc(sizeof(schedule_t) * o.threads);
+    for(int t=0; t < o.threads; t++){
+      schedule_init(& schedules[t], t);
+    }
+  }
+  const int total_num = o.duration ? INT_MAX : o.num;
+  for(int t=0; t < o.threads; t++){
+    schedules[t].start_index = start_index;
+    schedule_build(& schedules[t], t, total_num);
+  }
+}
+
+// account the result of the benchmark operations, returns 0 if the remaining operations for the object must be skipped
+static int bench_stat_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (o.verbosity >= 2){
+    printf("%d: stat %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+  }
+
+  if(ret != MD_SUCCESS && ret != MD_NOOP){
+    if (o.verbosity)
+      printf("%d: Error while stating the obj: %s\n", o.rank, dset);
+    s->obj_stat.err++;
+    return 0;
+  }
+  s->obj_stat.suc++;
+
+  if (o.verbosity >= 2){
+    printf("%d: read %s:%s \n", o.rank, dset, obj_name);
+  }
+  return 1;
+}
+
+static void bench_read_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (ret == MD_SUCCESS){
+    s->obj_read.suc++;
+  }else if (ret == MD_NOOP){
+    // nothing to do
+  }else if (ret == MD_ERROR_FIND){
+    printf("%d: Error while accessing the file %s (%s)\n", o.rank, dset, strerror(errno));
+    s->obj_read.err++;
+  }else{
+    printf("%d: Error while reading the file %s (%s)\n", o.rank, dset, strerror(errno));
+    s->obj_read.err++;
+  }
+}
+
+static void bench_delete_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (o.verbosity >= 2){
+    printf("%d: delete %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+  }
+
+  if (ret == MD_SUCCESS){
+    s->obj_delete.suc++;
+  }else if (ret == MD_NOOP){
+    // nothing to do
+  }else{
+    printf("%d: Error while deleting the object %s:%s\n", o.rank, dset, obj_name);
+    s->obj_delete.err++;
+  }
+}
+
+static void bench_write_done(phase_stat_t * s, int ret, char * dset, char * obj_name){
+  if (o.verbosity >= 2){
+    printf("%d: write %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+  }
+
+  if (ret == MD_SUCCESS){
+      s->obj_create.suc++;
+  }else if (ret == MD_ERROR_CREATE){
+    if (o.verbosity)
+      printf("%d: Error while creating the obj: %s\n",o.rank, dset);
+    s->obj_create.err++;
+  }else if (ret == MD_NOOP){
+      // do not increment any counter
+  }else{
+    if (o.verbosity)
+      printf("%d: Error while writing the obj: %s\n", o.rank, dset);
+    s->obj_create.err++;
+  }
+}
+
+/* With --mix and --replay the types have different numbers of samples, all arrays are valid up to the smallest one.
+   The arrays of types without any operation are cleared. */
+static size_t sampled_repeats(phase_stat_t * s, size_t samples[4], size_t sample_count){
+  time_result_t * times[] = {s->time_create, s->time_read, s->time_stat, s->time_delete};
+  size_t repeats = sample_count;
+  for(int t=0; t < 4; t++){
+    if(samples[t] > 0 && samples[t] < repeats){
+      repeats = samples[t];
+    }
+  }
+  for(int t=0; t < 4; t++){
+    if(samples[t] == 0){
+      memset(times[t], 0, repeats * sizeof(time_result_t));
+    }
+  }
+  return repeats;
+}
+
+/* With --duration the -P precreated objects of a process are recycled, the process reading them must not get
+   more than -P iterations ahead of the process creating them. The processes exchange their progress with a
+   chain of non-blocking reductions, a process waits only if it reaches the limit of the last result.
+   Once the duration is over for a process, all processes agree on the largest progress and end there. */
+static MPI_Comm pacing_comm;
+
+typedef struct{
+  MPI_Request request;
+  int send[3]; // the progress, its negation for the maximum, 0 once the duration is over
+  int recv[3];
+  int limit; // the first iteration that must not be started
+  int target; // the number of iterations of all processes, -1 until the duration is over
+} pacing_t;
+
+static void pacing_start(pacing_t * p, int progress, int running){
+  p->send[0] = progress;
+  p->send[1] = -progress;
+  p->send[2] = running;
+  int ret = MPI_Iallreduce(p->send, p->recv, 3, MPI_INT, MPI_MIN, pacing_comm, & p->request);
+  CHECK_MPI_RET(ret)
+}
+
+static void pacing_init(pacing_t * p){
+  p->limit = o.precreate;
+  p->target = -1;
+  pacing_start(p, 0, 1);
+}
+
+/* Progress the reductions before iteration f, f iterations have been completed, and wait while f is beyond the limit.
+   Returns the number of iterations to run. All processes must call it until the request is MPI_REQUEST_NULL. */
+static int pacing_progress(pacing_t * p, int f, double runtime){
+  while(p->request != MPI_REQUEST_NULL){
+    int flag = 1;
+    if(f < p->limit && (p->target < 0 || f < p->target)){
+      MPI_Test(& p->request, & flag, MPI_STATUS_IGNORE);
+      if(! flag){
+        break;
+      }
+    }else{
+      MPI_Wait(& p->request, MPI_STATUS_IGNORE);
+    }
+    p->limit = p->recv[0] + o.precreate;
+    if(p->target < 0 && ! p->recv[2]){
+      // all processes complete the same reduction before this one, so they all call it
+      int ret = MPI_Allreduce(& f, & p->target, 1, MPI_INT, MPI_MAX, pacing_comm);
+      CHECK_MPI_RET(ret)
+      timeline_instant("wear-out");
+      if(o.rank == 0){
+        printf("duration wear out %fs (%d iter)\n", runtime, p->target);
       }
+    }
+    if(p->target >= 0 && p->recv[0] == p->target){
+      break; // all processes have completed the target
+    }
+    pacing_start(p, f, runtime < o.duration);
+  }
+  return p->target < 0 ? INT_MAX : p->target;
+}
 
-      int writeRank = (o.rank + o.offset * (d+1)) % o.size;
-      ret = o.plugin->def_obj_name(obj_name, writeRank, d, o.precreate + prevFile);
-      if (ret != MD_SUCCESS){
+/* FIFO: create a new file, write to it. Then read from the first created file, delete it...
+   The operations are taken from the schedule prepared by prepare_benchmark(). */
+void run_benchmark(phase_stat_t * s, int * current_index_p, int thread){
+  schedule_t * sc = & schedules[thread];
+  int ret;
+  char * buf = malloc(md_size_dist_max(& size_dist));
+  memset(buf, o.rank % 256, md_size_dist_max(& size_dist));
+  timer op_timer; // timer for individual operations
+  size_t pos = -1; // number of the processed object
+  size_t type_samples[4] = {0, 0, 0, 0}; // with --mix, the samples of each md_op_type
+  // with --duration the measurement array keeps the samples of the last -I iterations
+  const size_t sample_count = s->repeats;
+  int total_num = o.duration ? INT_MAX : o.num;
+  int armed_stone_wall = (o.stonewall_timer > 0);
+  int f;
+  double phase_allreduce_time = 0;
+  arrival_t arrival;
+  arrival_init(& arrival, thread);
+  pacing_t pacing;
+  if(o.duration){
+    pacing_init(& pacing);
+  }
+
+  for(f=thread; f < total_num; f += o.threads){
+    float bench_runtime = 0; // the time since start
+    if(o.duration){
+      total_num = pacing_progress(& pacing, f, stop_timer(s->phase_start_timer));
+      if(f >= total_num){
+        break;
+      }
+    }
+    if(f >= sc->end){
+      // only with --duration or a huge number of iterations
+      schedule_build(sc, f, total_num);
+    }
+    sched_op_t * op = sc->ops + (size_t) ((f - sc->first) / o.threads) * sc->ops_per_iteration;
+    sched_op_t * const iteration_end = op + sc->ops_per_iteration;
+    size_t sample = 0; // position inside the individual measurement array
+    for(; op < iteration_end; op++){
+      uint64_t op_ns;
+      if(use_mix){
+        sample = type_samples[op->type]++ % sample_count;
+      }else if((op - sc->ops) % sc->ops_per_obj == 0){
+        pos++;
+        sample = pos % sample_count;
+      }
+      if(op->obj_name == SCHED_NO_NAME){
         s->obj_name.err++;
+        if(op->type == MD_OP_WRITE){
+          continue;
+        }
+        // skip the remaining operations of the object
+        op += sc->ops_per_obj - 1 - (op - sc->ops) % sc->ops_per_obj;
         continue;
       }
-      ret = o.plugin->def_dset_name(dset, writeRank, d);
+      char * dset = sc->names + op->dset_name;
+      char * obj_name = sc->names + op->obj_name;
 
-      start_timer(& op_timer);
-      ret = o.plugin->write_obj(dset, obj_name, buf, o.file_size);
-      bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_create, pos, & s->max_op_time, & op_time);
-      if(o.relative_waiting_factor > 1e-9) {
-        wait(op_time);
+      uint64_t perf_start[MD_PC_COUNT];
+      if(o.perf_counters_ops){
+        md_perf_read(& perf_counters, perf_start);
       }
-
-      if (o.verbosity >= 2){
-        printf("%d: write %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+      start_op_timer(s, & arrival, & op_timer);
+      start_op_cpu(s);
+      switch(op->type){
+        case(MD_OP_STAT):
+          ret = o.plugin->stat_obj(dset, obj_name, op->size);
+          bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_stat, s->hist_stat, sample, & s->max_op_time, & op_ns);
+          break;
+        case(MD_OP_READ):
+          ret = o.plugin->read_obj(dset, obj_name, buf, op->size);
+          bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_read, s->hist_read, sample, & s->max_op_time, & op_ns);
+          break;
+        case(MD_OP_DELETE):
+          ret = o.plugin->delete_obj(dset, obj_name);
+          bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_delete, s->hist_delete, sample, & s->max_op_time, & op_ns);
+          break;
+        default:
+          ret = o.plugin->write_obj(dset, obj_name, buf, op->size);
+          bench_runtime = add_timed_result(op_timer, s->phase_start_timer, s->time_create, s->hist_create, sample, & s->max_op_time, & op_ns);
       }
-
-      if (ret == MD_SUCCESS){
-          s->obj_create.suc++;
-      }else if (ret == MD_ERROR_CREATE){
-        if (o.verbosity)
-          printf("%d: Error while creating the obj: %s\n",o.rank, dset);
-        s->obj_create.err++;
-      }else if (ret == MD_NOOP){
-          // do not increment any counter
-      }else{
-        if (o.verbosity)
-          printf("%d: Error while writing the obj: %s\n", o.rank, dset);
-        s->obj_create.err++;
+      if(o.perf_counters_ops){
+        perf_op_add(s, op->type, perf_start);
+      }
+      record_op(s, op->type, op_timer, op_ns, op->obj_rank, op->dset, op->obj, op->size, ret);
+      if(o.relative_waiting_factor > 1e-9) {
+        wait(op_ns * 1e-9);
+      }
+      switch(op->type){
+        case(MD_OP_STAT):
+          if(! bench_stat_done(s, ret, dset, obj_name)){
+            op += sc->ops_per_obj - 1;
+          }
+          break;
+        case(MD_OP_READ):
+          bench_read_done(s, ret, dset, obj_name);
+          break;
+        case(MD_OP_DELETE):
+          bench_delete_done(s, ret, dset, obj_name);
+          break;
+        default:
+          bench_write_done(s, ret, dset, obj_name);
       }
     } // end loop
 
@@ -759,9 +2173,11 @@ void run_benchmark(phase_stat_t * s, int * current_index_p){
       }
       if(! o.stonewall_timer_wear_out){
         s->stonewall_iterations = f;
+        timeline_instant("stonewall");
         break;
       }
       armed_stone_wall = 0;
+      timeline_instant("stonewall");
       // wear out mode, now reduce the maximum
       int cur_pos = f + 1;
       phase_allreduce_time = stop_timer(s->phase_start_timer);
@@ -769,6 +2185,7 @@ void run_benchmark(phase_stat_t * s, int * current_index_p){
       start_timer(& s->phase_start_timer);
       CHECK_MPI_RET(ret)
       s->stonewall_iterations = total_num;
+      timeline_instant("wear-out");
       if(o.rank == 0){
         printf("stonewall wear out %fs (%d iter)\n", bench_runtime, total_num);
       }
@@ -784,63 +2201,775 @@ void run_benchmark(phase_stat_t * s, int * current_index_p){
     CHECK_MPI_RET(ret)
     s->stonewall_iterations = total_num;
   }
-  if(o.stonewall_timer && ! o.stonewall_timer_wear_out){
-    // TODO FIXME
-    int sh = s->stonewall_iterations;
-    int ret = MPI_Allreduce(& sh, & s->stonewall_iterations, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
-    CHECK_MPI_RET(ret)
+  if(o.duration){
+    // the process takes part in the reductions until all processes have completed the target
+    while(pacing.request != MPI_REQUEST_NULL){
+      pacing_progress(& pacing, f, 0);
+    }
+    s->stonewall_iterations = total_num;
+  }
+
+  if(use_mix){
+    s->mix_iterations = min(f, total_num);
+    *current_index_p += mix.count[MD_OP_DELETE] * s->mix_iterations;
+    s->repeats = sampled_repeats(s, type_samples, sample_count);
+  }else{
+    if(! o.read_only) {
+      *current_index_p += min(f, total_num);
+    }
+    s->repeats = min(pos + 1, sample_count);
+  }
+  free(buf);
+}
+
+// an object processed by the asynchronous benchmark, its operations are issued in FIFO order
+typedef struct{
+  md_async_op_t op; // must be the first member to map the completed op back to the slot
+  int f;
+  int d;
+  size_t pos;
+  timer op_timer;
+  char dset[4096];
+  char obj_name[4096];
+} async_slot_t;
+
+static int async_submit(async_slot_t * slot, md_op_type type, int start_index){
+  slot->op.type = type;
+  slot->op.dset = slot->dset;
+  slot->op.name = slot->obj_name;
+  if(type == MD_OP_WRITE){
+    slot->op.size = obj_size(bench_write_rank(slot->d), slot->d, o.precreate + slot->f + start_index);
+  }else{
+    slot->op.size = obj_size(bench_read_rank(slot->d), slot->d, slot->f + start_index);
+  }
+  start_timer(& slot->op_timer);
+  return o.plugin->submit_op(& slot->op);
+}
+
+// account the completed operation of the slot, returns the next operation for the object or -1 if it is done
+static int async_complete_step(phase_stat_t * s, async_slot_t * slot, int start_index){
+  uint64_t op_ns;
+  const int ret = slot->op.ret;
+  switch(slot->op.type){
+    case(MD_OP_STAT):
+      add_timed_result(slot->op_timer, s->phase_start_timer, s->time_stat, s->hist_stat, slot->pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_STAT, slot->op_timer, op_ns, bench_read_rank(slot->d), slot->d, slot->f + start_index, slot->op.size, ret);
+      if(! bench_stat_done(s, ret, slot->dset, slot->obj_name)){
+        return -1;
+      }
+      return MD_OP_READ;
+    case(MD_OP_READ):
+      add_timed_result(slot->op_timer, s->phase_start_timer, s->time_read, s->hist_read, slot->pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_READ, slot->op_timer, op_ns, bench_read_rank(slot->d), slot->d, slot->f + start_index, slot->op.size, ret);
+      bench_read_done(s, ret, slot->dset, slot->obj_name);
+      return o.read_only ? -1 : MD_OP_DELETE;
+    case(MD_OP_DELETE):
+      add_timed_result(slot->op_timer, s->phase_start_timer, s->time_delete, s->hist_delete, slot->pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_DELETE, slot->op_timer, op_ns, bench_read_rank(slot->d), slot->d, slot->f + start_index, slot->op.size, ret);
+      bench_delete_done(s, ret, slot->dset, slot->obj_name);
+      if (bench_write_obj_name(slot->dset, slot->obj_name, slot->f, slot->d, start_index) != MD_SUCCESS){
+        s->obj_name.err++;
+        return -1;
+      }
+      return MD_OP_WRITE;
+    case(MD_OP_WRITE):
+      add_timed_result(slot->op_timer, s->phase_start_timer, s->time_create, s->hist_create, slot->pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_WRITE, slot->op_timer, op_ns, bench_write_rank(slot->d), slot->d, o.precreate + slot->f + start_index, slot->op.size, ret);
+      bench_write_done(s, ret, slot->dset, slot->obj_name);
+      return -1;
+  }
+  return -1;
+}
+
+// process the completed operation and submit the next one, returns 1 if an operation of the object is in flight
+static int async_advance(phase_stat_t * s, async_slot_t * slot, int start_index){
+  while(1){
+    int next = async_complete_step(s, slot, start_index);
+    if(next < 0){
+      return 0;
+    }
+    int ret = async_submit(slot, (md_op_type) next, start_index);
+    if(ret == MD_SUCCESS){
+      return 1;
+    }
+    // a failed submission is accounted as completed operation
+    slot->op.ret = ret;
+  }
+}
+
+/* Same FIFO pattern as run_benchmark() but keeps up to queue-depth objects in flight.
+   The latency of an operation covers the time from submission until its completion has been observed. */
+void run_benchmark_async(phase_stat_t * s, int * current_index_p){
+  const int start_index = *current_index_p;
+  async_slot_t * slots = malloc(sizeof(async_slot_t) * o.queue_depth);
+  async_slot_t ** free_slots = malloc(sizeof(async_slot_t *) * o.queue_depth);
+  int free_count = o.queue_depth;
+  for(int i=0; i < o.queue_depth; i++){
+    slots[i].op.buf = malloc(md_size_dist_max(& size_dist));
+    memset(slots[i].op.buf, o.rank % 256, md_size_dist_max(& size_dist));
+    free_slots[i] = & slots[i];
+  }
+
+  size_t pos = -1; // position inside the individual measurement array
+  int outstanding = 0;
+  int f = 0;
+  int d = 0;
+  int issue = 1;
+
+  while(1){
+    while(issue && free_count > 0 && f < o.num){
+      if(d == 0 && o.stonewall_timer > 0 && stop_timer(s->phase_start_timer) >= o.stonewall_timer){
+        if(o.verbosity){
+          printf("%d: stonewall runtime %fs (%ds)\n", o.rank, stop_timer(s->phase_start_timer), o.stonewall_timer);
+        }
+        s->stonewall_iterations = f;
+        timeline_instant("stonewall");
+        issue = 0;
+        break;
+      }
+      async_slot_t * slot = free_slots[--free_count];
+      slot->f = f;
+      slot->d = d;
+      slot->pos = ++pos;
+      if(++d == o.dset_count){
+        d = 0;
+        f++;
+      }
+
+      if (bench_read_obj_name(slot->dset, slot->obj_name, slot->f, slot->d, start_index) != MD_SUCCESS){
+        s->obj_name.err++;
+        free_slots[free_count++] = slot;
+        continue;
+      }
+      int ret = async_submit(slot, MD_OP_STAT, start_index);
+      if(ret != MD_SUCCESS){
+        slot->op.ret = ret;
+        if(! async_advance(s, slot, start_index)){
+          free_slots[free_count++] = slot;
+          continue;
+        }
+      }
+      outstanding++;
+    }
+    if(outstanding == 0){
+      break;
+    }
+
+    async_slot_t * slot = (async_slot_t *) o.plugin->complete_op();
+    if(slot == NULL){
+      printf("%d: Error, the plugin did not return a completed operation\n", o.rank);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if(! async_advance(s, slot, start_index)){
+      outstanding--;
+      free_slots[free_count++] = slot;
+    }
+  }
+  s->t = stop_timer(s->phase_start_timer);
+
+  if(! o.read_only) {
+    *current_index_p += f;
+  }
+  s->repeats = pos + 1;
+  for(int i=0; i < o.queue_depth; i++){
+    free(slots[i].op.buf);
+  }
+  free(free_slots);
+  free(slots);
+}
+
+/* Same FIFO pattern as run_benchmark() but each step is issued for a batch of objects:
+   stat all objects, then read and delete the existing ones and finally create the new objects. */
+void run_benchmark_batched(phase_stat_t * s, int * current_index_p, int thread){
+  const int start_index = *current_index_p;
+  char * buf = malloc(md_size_dist_max(& size_dist));
+  memset(buf, o.rank % 256, md_size_dist_max(& size_dist));
+  batch_t batch;
+  batch_init(& batch, buf);
+  size_t pos = -1; // position inside the individual measurement array
+  int f = thread;
+  int d = 0;
+
+  while(f < o.num){
+    batch.count = 0;
+    while(batch.count < o.batch && f < o.num){
+      if(d == 0 && o.stonewall_timer > 0 && stop_timer(s->phase_start_timer) >= o.stonewall_timer){
+        if(o.verbosity){
+          printf("%d: stonewall runtime %fs (%ds)\n", o.rank, stop_timer(s->phase_start_timer), o.stonewall_timer);
+        }
+        s->stonewall_iterations = f;
+        timeline_instant("stonewall");
+        break;
+      }
+      md_obj_t * obj = batch_add(& batch, ++pos, f, d);
+      batch.items[batch.count - 1].obj_rank = bench_read_rank(d);
+      batch.items[batch.count - 1].obj = f + start_index;
+      if (bench_read_obj_name(obj->dset, obj->name, f, d, start_index) != MD_SUCCESS){
+        s->obj_name.err++;
+        batch.count--;
+      }
+      if(++d == o.dset_count){
+        d = 0;
+        f += o.threads;
+      }
+    }
+    if(batch.count == 0){
+      break;
+    }
+
+    batch_run(s, & batch, MD_OP_STAT);
+    int kept = 0;
+    for(int i=0; i < batch.count; i++){
+      if(bench_stat_done(s, batch.objs[i].ret, batch.objs[i].dset, batch.objs[i].name)){
+        batch_keep(& batch, i, & kept);
+      }
+    }
+    batch.count = kept;
+
+    batch_run(s, & batch, MD_OP_READ);
+    for(int i=0; i < batch.count; i++){
+      bench_read_done(s, batch.objs[i].ret, batch.objs[i].dset, batch.objs[i].name);
+    }
+    if(o.read_only){
+      continue;
+    }
+
+    batch_run(s, & batch, MD_OP_DELETE);
+    kept = 0;
+    for(int i=0; i < batch.count; i++){
+      md_obj_t * obj = & batch.objs[i];
+      bench_delete_done(s, obj->ret, obj->dset, obj->name);
+      if (bench_write_obj_name(obj->dset, obj->name, batch.items[i].f, batch.items[i].d, start_index) != MD_SUCCESS){
+        s->obj_name.err++;
+        continue;
+      }
+      batch.items[i].obj_rank = bench_write_rank(batch.items[i].d);
+      batch.items[i].obj = o.precreate + batch.items[i].f + start_index;
+      batch_keep(& batch, i, & kept);
+    }
+    batch.count = kept;
+
+    batch_run(s, & batch, MD_OP_WRITE);
+    for(int i=0; i < batch.count; i++){
+      bench_write_done(s, batch.objs[i].ret, batch.objs[i].dset, batch.objs[i].name);
+    }
+  }
+  s->t = stop_timer(s->phase_start_timer);
+
+  if(! o.read_only) {
+    *current_index_p += min(f, o.num);
+  }
+  s->repeats = pos + 1;
+  batch_free(& batch);
+  free(buf);
+}
+
+static void cleanup_dset(phase_stat_t * s, char * dset){
+  const int ret = o.plugin->rm_dset(dset);
+
+  if (o.verbosity >= 2){
+    printf("%d: delete dset %s (%d)\n", o.rank, dset, ret);
+  }
+
+  if (ret == MD_SUCCESS){
+    s->dset_delete.suc++;
+  }else if (ret != MD_NOOP){
+    s->dset_delete.err++;
+  }
+}
+
+void run_cleanup(phase_stat_t * s, int start_index, int thread){
+  char dset[4096];
+  char obj_name[4096];
+  int ret;
+  timer op_timer; // timer for individual operations
+  size_t pos = -1; // position inside the individual measurement array
+
+  batch_t batch;
+  if(o.batch > 1){
+    batch_init(& batch, NULL);
+  }
+
+  for(int d=0; d < o.dset_count; d++){
+    ret = define_dset_name(dset, o.rank, d);
+
+    for(int f=thread; f < working_set; f += o.threads){
+      uint64_t op_ns;
+      pos++;
+      if(o.batch > 1){
+        md_obj_t * obj = batch_add(& batch, pos, f, d);
+        batch.items[batch.count - 1].obj = f + start_index;
+        strcpy(obj->dset, dset);
+        define_obj_name(obj->name, o.rank, d, f + start_index);
+        if(batch.count == o.batch){
+          cleanup_delete_batch(s, & batch);
+        }
+        continue;
+      }
+      ret = define_obj_name(obj_name, o.rank, d, f + start_index);
+
+      start_op_cpu(s);
+      start_timer(& op_timer);
+      ret = o.plugin->delete_obj(dset, obj_name);
+      add_timed_result(op_timer, s->phase_start_timer, s->time_delete, s->hist_delete, pos, & s->max_op_time, & op_ns);
+      record_op(s, MD_OP_DELETE, op_timer, op_ns, o.rank, d, f + start_index, 0, ret);
+      cleanup_delete_done(s, ret, dset, obj_name);
+    }
+    if(o.batch > 1){
+      // the objects must be removed before the dataset
+      cleanup_delete_batch(s, & batch);
+    }
+
+    wait_for_threads();
+    if(o.shared_dsets > 1){
+      // the leader removes the data set once all members of the group deleted their objects
+      MPI_Barrier(shared_comm);
+      if(o.rank != shared_leader(o.rank)){
+        continue;
+      }
+    }
+
+    // the directories of the tree bottom-up, see --tree-depth
+    for(int depth=o.tree_depth; depth > 0; depth--){
+      for(int node=tree_first[depth] + thread; node < tree_first[depth + 1]; node += o.threads){
+        char dir[4096];
+        tree_node_name(dir, o.rank, d, node);
+        cleanup_dset(s, dir);
+      }
+      wait_for_threads();
+    }
+    if(d % o.threads != thread){
+      continue;
+    }
+    cleanup_dset(s, dset);
+  }
+  if(o.batch > 1){
+    batch_free(& batch);
+  }
+  s->repeats = pos + 1;
+}
+
+// the state of the data sets and objects of the trace, see --replay
+#define REPLAY_USED 1
+#define REPLAY_EXISTS 2
+#define REPLAY_PREPARE 4 // accessed before the trace creates it
+
+/* Derive from the trace which data sets and objects must exist before the replay and create them,
+   data sets are required for all objects. The time is not included in the replay phase.
+   Afterwards, the state of an entry tells if it exists, it is maintained by run_replay(), see replay_remove(). */
+static void replay_prepare(){
+  char dset[4096];
+  char obj_name[4096];
+  char err[1024];
+  md_replay_op_t op;
+  int ret;
+  uint64_t counts[5] = {0, 0, 0, 0, 0}; // operations, data sets, prepared data sets, objects, prepared objects
+
+  replay_max_size = o.file_size;
+  while((ret = md_replay_next(replay, & op, err)) > 0){
+    counts[0]++;
+    md_replay_entry_t * d = op.dset;
+    if(op.obj == NULL){
+      if(d->state == 0){
+        d->state = REPLAY_USED | (op.type == MD_REPLAY_RMDIR ? REPLAY_EXISTS | REPLAY_PREPARE : 0);
+      }
+      d->state = op.type == MD_REPLAY_MKDIR ? d->state | REPLAY_EXISTS : d->state & ~REPLAY_EXISTS;
+      continue;
+    }
+    if(d->state == 0){
+      d->state = REPLAY_USED | REPLAY_EXISTS | REPLAY_PREPARE;
+    }
+    md_replay_entry_t * e = op.obj;
+    const size_t size = op.size >= 0 ? (size_t) op.size : (size_t) o.file_size;
+    if(e->state == 0){
+      e->state = REPLAY_USED | (op.type != MD_OP_WRITE ? REPLAY_PREPARE : 0);
+      e->size = (uint32_t) size;
+      if(e->state & REPLAY_PREPARE){
+        // even if the trace creates the data set, it cannot create it before the replay
+        d->state |= REPLAY_PREPARE;
+      }
+    }
+    e->state = op.type == MD_OP_DELETE ? e->state & ~REPLAY_EXISTS : e->state | REPLAY_EXISTS;
+    replay_max_size = size > replay_max_size ? size : replay_max_size;
+  }
+  if(ret < 0){
+    printf("%d: Error in the trace %s-%d.txt: %s\n", o.rank, o.replay, o.rank, err);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  size_t slots;
+  md_replay_entry_t * e = md_replay_entries(replay, 0, & slots);
+  for(size_t i=0; i < slots; i++){
+    e[i].state &= ~REPLAY_EXISTS;
+    if(! (e[i].state & REPLAY_PREPARE)){
+      continue;
+    }
+    counts[2]++;
+    o.plugin->def_dset_name(dset, o.rank, e[i].id);
+    ret = o.plugin->create_dset(dset);
+    if(ret == MD_SUCCESS || ret == MD_NOOP){
+      e[i].state |= REPLAY_EXISTS;
+    }else if(! o.ignore_precreate_errors){
+      printf("%d: Error while creating the dset: %s\n", o.rank, dset);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+  char * buf = malloc(replay_max_size > 0 ? replay_max_size : 1);
+  memset(buf, o.rank % 256, replay_max_size);
+  e = md_replay_entries(replay, 1, & slots);
+  for(size_t i=0; i < slots; i++){
+    e[i].state &= ~REPLAY_EXISTS;
+    if(! (e[i].state & REPLAY_PREPARE)){
+      continue;
+    }
+    counts[4]++;
+    o.plugin->def_dset_name(dset, o.rank, e[i].dset);
+    o.plugin->def_obj_name(obj_name, o.rank, e[i].dset, e[i].id);
+    ret = o.plugin->write_obj(dset, obj_name, buf, e[i].size);
+    if(ret == MD_SUCCESS || ret == MD_NOOP){
+      e[i].state |= REPLAY_EXISTS;
+    }else if(! o.ignore_precreate_errors){
+      printf("%d: Error while creating the obj: %s\n", o.rank, obj_name);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+  free(buf);
+  counts[1] = md_replay_count(replay, 0);
+  counts[3] = md_replay_count(replay, 1);
+
+  uint64_t total[5];
+  MPI_Reduce(counts, total, 5, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+  if(o.rank == 0 && ! o.quiet_output){
+    printf("Replay: %s-<rank>.txt ops:%llu dsets:%llu (prepared:%llu) objects:%llu (prepared:%llu) ", o.replay, LLU total[0], LLU total[1], LLU total[2], LLU total[3], LLU total[4]);
+    if(o.replay_speed > 0){
+      printf("speed:%.2f\n", o.replay_speed);
+    }else{
+      printf("speed:as-fast-as-possible\n");
+    }
+  }
+}
+
+// remove the data sets and objects that exist after the replay, the time is not included in the replay phase
+static void replay_remove(){
+  char dset[4096];
+  char obj_name[4096];
+  int errors = 0;
+  size_t slots;
+  md_replay_entry_t * e = md_replay_entries(replay, 1, & slots);
+  for(size_t i=0; i < slots; i++){
+    if(e[i].state & REPLAY_EXISTS){
+      o.plugin->def_dset_name(dset, o.rank, e[i].dset);
+      o.plugin->def_obj_name(obj_name, o.rank, e[i].dset, e[i].id);
+      const int ret = o.plugin->delete_obj(dset, obj_name);
+      errors += ret != MD_SUCCESS && ret != MD_NOOP;
+    }
+  }
+  e = md_replay_entries(replay, 0, & slots);
+  for(size_t i=0; i < slots; i++){
+    if(e[i].state & REPLAY_EXISTS){
+      o.plugin->def_dset_name(dset, o.rank, e[i].id);
+      const int ret = o.plugin->rm_dset(dset);
+      errors += ret != MD_SUCCESS && ret != MD_NOOP;
+    }
+  }
+  if(errors > 0){
+    printf("%d: Error while removing %d data sets and objects of the replay\n", o.rank, errors);
   }
+}
 
-  if(! o.read_only) {
-    *current_index_p += f;
+/* Like start_op_timer() but the intended start is given by the inter-arrival times of the trace,
+   scaled by --replay-speed. Without a speed, the operations are issued as fast as possible.
+   An operation without an inter-arrival time depends on its predecessor and starts once it is completed. */
+static void start_replay_timer(phase_stat_t * s, double * intended, double delay, timer * op_timer){
+  if(o.replay_speed <= 0){
+    start_timer(op_timer);
+    return;
   }
-  s->repeats = pos + 1;
-  free(buf);
+  const double now = stop_timer(s->phase_start_timer);
+  if(delay <= 0){
+    *intended = now;
+    start_timer(op_timer);
+    return;
+  }
+  *intended += delay / o.replay_speed;
+  if(now > *intended + o.deadline_tolerance){
+    s->missed_deadlines++;
+  }else if(now < *intended){
+    wait_for(*intended - now);
+  }
+  *op_timer = s->phase_start_timer;
+  timer_add(op_timer, *intended);
 }
 
-void run_cleanup(phase_stat_t * s, int start_index){
+/* Replay the operations of the trace in its order, the names are defined by the plugin for the number of the
+   data set and object, see md_replay.h. The size of an object is the size of its last create. */
+void run_replay(phase_stat_t * s){
   char dset[4096];
   char obj_name[4096];
-  int ret;
+  char err[1024];
+  char * buf = malloc(replay_max_size > 0 ? replay_max_size : 1);
+  memset(buf, o.rank % 256, replay_max_size);
   timer op_timer; // timer for individual operations
-  size_t pos = -1; // position inside the individual measurement array
+  size_t type_samples[4] = {0, 0, 0, 0};
+  // the measurement array keeps the samples of the last operations of each type
+  const size_t sample_count = s->repeats;
+  double intended = 0;
+  md_replay_op_t op;
+  int ret;
 
-  for(int d=0; d < o.dset_count; d++){
-    ret = o.plugin->def_dset_name(dset, o.rank, d);
+  md_replay_rewind(replay);
+  while(md_replay_next(replay, & op, err) > 0){
+    o.plugin->def_dset_name(dset, o.rank, op.dset->id);
+    if(op.obj == NULL){
+      start_replay_timer(s, & intended, op.delay, & op_timer);
+      op_stat_t * stat = op.type == MD_REPLAY_MKDIR ? & s->dset_create : & s->dset_delete;
+      ret = op.type == MD_REPLAY_MKDIR ? o.plugin->create_dset(dset) : o.plugin->rm_dset(dset);
+      if (o.verbosity >= 2){
+        printf("%d: %s dset %s (%d)\n", o.rank, op.type == MD_REPLAY_MKDIR ? "create" : "delete", dset, ret);
+      }
+      if (ret == MD_SUCCESS){
+        stat->suc++;
+      }else if (ret != MD_NOOP){
+        stat->err++;
+        continue;
+      }
+      op.dset->state = op.type == MD_REPLAY_MKDIR ? op.dset->state | REPLAY_EXISTS : op.dset->state & ~REPLAY_EXISTS;
+      continue;
+    }
+    md_replay_entry_t * e = op.obj;
+    const md_op_type type = (md_op_type) op.type;
+    if(type == MD_OP_WRITE){
+      e->size = (uint32_t) (op.size >= 0 ? (size_t) op.size : (size_t) o.file_size);
+    }
+    o.plugin->def_obj_name(obj_name, o.rank, e->dset, e->id);
+    const size_t sample = type_samples[type]++ % sample_count;
+    uint64_t op_ns;
 
-    for(int f=0; f < o.precreate; f++){
-      double op_time;
-      pos++;
-      ret = o.plugin->def_obj_name(obj_name, o.rank, d, f + start_index);
+    uint64_t perf_start[MD_PC_COUNT];
+    if(o.perf_counters_ops){
+      md_perf_read(& perf_counters, perf_start);
+    }
+    start_replay_timer(s, & intended, op.delay, & op_timer);
+    start_op_cpu(s);
+    switch(type){
+      case(MD_OP_STAT):
+        ret = o.plugin->stat_obj(dset, obj_name, e->size);
+        add_timed_result(op_timer, s->phase_start_timer, s->time_stat, s->hist_stat, sample, & s->max_op_time, & op_ns);
+        break;
+      case(MD_OP_READ):
+        ret = o.plugin->read_obj(dset, obj_name, buf, e->size);
+        add_timed_result(op_timer, s->phase_start_timer, s->time_read, s->hist_read, sample, & s->max_op_time, & op_ns);
+        break;
+      case(MD_OP_DELETE):
+        ret = o.plugin->delete_obj(dset, obj_name);
+        add_timed_result(op_timer, s->phase_start_timer, s->time_delete, s->hist_delete, sample, & s->max_op_time, & op_ns);
+        break;
+      default:
+        ret = o.plugin->write_obj(dset, obj_name, buf, e->size);
+        add_timed_result(op_timer, s->phase_start_timer, s->time_create, s->hist_create, sample, & s->max_op_time, & op_ns);
+    }
+    if(o.perf_counters_ops){
+      perf_op_add(s, type, perf_start);
+    }
+    record_op(s, type, op_timer, op_ns, o.rank, e->dset, e->id, e->size, ret);
+    if(ret == MD_SUCCESS && (type == MD_OP_WRITE || type == MD_OP_DELETE)){
+      e->state = type == MD_OP_WRITE ? e->state | REPLAY_EXISTS : e->state & ~REPLAY_EXISTS;
+    }
+    switch(type){
+      case(MD_OP_STAT):
+        bench_stat_done(s, ret, dset, obj_name);
+        break;
+      case(MD_OP_READ):
+        bench_read_done(s, ret, dset, obj_name);
+        break;
+      case(MD_OP_DELETE):
+        bench_delete_done(s, ret, dset, obj_name);
+        break;
+      default:
+        bench_write_done(s, ret, dset, obj_name);
+    }
+  }
+  s->repeats = sampled_repeats(s, type_samples, sample_count);
+  free(buf);
+}
 
-      start_timer(& op_timer);
-      ret = o.plugin->delete_obj(dset, obj_name);
-      add_timed_result(op_timer, s->phase_start_timer, s->time_delete, pos, & s->max_op_time, & op_time);
+typedef enum{
+  PHASE_PRECREATE,
+  PHASE_BENCHMARK,
+  PHASE_CLEANUP,
+  PHASE_REPLAY
+} phase_t;
 
-      if (o.verbosity >= 2){
-        printf("%d: delete %s:%s (%d)\n", o.rank, dset, obj_name, ret);
+typedef struct{
+  pthread_t thread;
+  int id;
+  phase_t phase;
+  phase_stat_t stat;
+  int current_index;
+} worker_t;
+
+static void run_phase_thread(phase_t phase, phase_stat_t * s, int * current_index_p, int thread){
+  switch(phase){
+    case(PHASE_PRECREATE):
+      run_precreate(s, *current_index_p, thread);
+      break;
+    case(PHASE_BENCHMARK):
+      if(o.queue_depth > 1 && o.plugin->submit_op){
+        run_benchmark_async(s, current_index_p);
+      }else if(o.batch > 1){
+        run_benchmark_batched(s, current_index_p, thread);
+      }else{
+        run_benchmark(s, current_index_p, thread);
       }
+      break;
+    case(PHASE_CLEANUP):
+      run_cleanup(s, *current_index_p, thread);
+      break;
+    case(PHASE_REPLAY):
+      run_replay(s);
+      break;
+  }
+}
+
+static void * worker_main(void * arg){
+  worker_t * w = (worker_t *) arg;
+  run_phase_thread(w->phase, & w->stat, & w->current_index, w->id);
+  return NULL;
+}
+
+// merge the statistics of a thread into the statistics of the process
+static void merge_thread_stats(phase_stat_t * s, phase_stat_t * t){
+  int * s_counters = & s->dset_name.suc;
+  int * t_counters = & t->dset_name.suc;
+  for(int i=0; i < 2*(3+5); i++){
+    s_counters[i] += t_counters[i];
+  }
+  s->t = t->t > s->t ? t->t : s->t;
+  s->max_op_time = t->max_op_time > s->max_op_time ? t->max_op_time : s->max_op_time;
+  s->stonewall_iterations = t->stonewall_iterations > s->stonewall_iterations ? t->stonewall_iterations : s->stonewall_iterations;
+  s->mix_iterations = t->mix_iterations > s->mix_iterations ? t->mix_iterations : s->mix_iterations;
+  s->bytes_written += t->bytes_written;
+  s->bytes_read += t->bytes_read;
+  s->missed_deadlines += t->missed_deadlines;
+  for(int i=0; i < 4; i++){
+    s->cpu_op[i] += t->cpu_op[i];
+    s->cpu_op_wall[i] += t->cpu_op_wall[i];
+    s->cpu_op_count[i] += t->cpu_op_count[i];
+  }
+
+  // the measurements of each thread are stored in its own slice of the process arrays, make them contiguous
+  const size_t count = t->repeats * sizeof(time_result_t);
+  memmove(s->time_create + s->repeats, t->time_create, count);
+  memmove(s->time_read + s->repeats, t->time_read, count);
+  memmove(s->time_stat + s->repeats, t->time_stat, count);
+  memmove(s->time_delete + s->repeats, t->time_delete, count);
+  s->repeats += t->repeats;
+
+  if(t->trace_count > 0){
+    s->trace = realloc(s->trace, (s->trace_count + t->trace_count) * sizeof(md_trace_record_t));
+    memcpy(s->trace + s->trace_count, t->trace, t->trace_count * sizeof(md_trace_record_t));
+    s->trace_count += t->trace_count;
+    s->trace_capacity = s->trace_count;
+  }
+
+  md_histogram_t ** s_hists = & s->hist_create;
+  md_histogram_t ** t_hists = & t->hist_create;
+  for(int i=0; i < HIST_COUNT; i++){
+    md_hist_merge(s_hists[i], t_hists[i]);
+  }
+  for(int i=0; s->hist_depth && i <= o.tree_depth; i++){
+    md_hist_merge(depth_hist(s->hist_depth, i), depth_hist(t->hist_depth, i));
+  }
+}
 
-      if (ret == MD_NOOP){
-        // nothing to do
-      }else if (ret == MD_SUCCESS){
-        s->obj_delete.suc++;
-      }else if(ret != MD_NOOP){
-        s->obj_delete.err++;
+// run the phase with all threads, the results are merged into s before the MPI reductions
+static void run_phase(phase_t phase, phase_stat_t * s, int * current_index_p){
+  const char * phase_names[] = {"precreate", "benchmark", "cleanup", "replay"};
+  const char * phase_end_names[] = {"precreate end", "benchmark end", "cleanup end", "replay end"};
+  timeline_instant(phase_names[phase]);
+  if(o.report_interval > 0){
+    interval_report = md_interval_init(phase_names[phase], o.report_interval, o.latency_precision, interval_comm, hist_type, hist_op);
+  }
+  if(o.latency_file_prefix && o.rank == 0 && ! o.latency_keep_all){
+    // the file for each md_op_type
+    const char * file_names[][MD_LAT_WRITER_FILES] = {
+      {"precreate", NULL, NULL, NULL},
+      {"create", "read", "stat", "delete"},
+      {NULL, NULL, NULL, "cleanup"},
+      {"replay-create", "replay-read", "replay-stat", "replay-delete"}};
+    char files[MD_LAT_WRITER_FILES][1024];
+    char * file_p[MD_LAT_WRITER_FILES];
+    for(int i=0; i < MD_LAT_WRITER_FILES; i++){
+      file_p[i] = NULL;
+      if(file_names[phase][i]){
+        sprintf(files[i], "%s-%.2f-%d-%s.csv", o.latency_file_prefix, o.relative_waiting_factor, global_iteration, file_names[phase][i]);
+        file_p[i] = files[i];
       }
     }
+    latency_writer = md_lat_writer_start(file_p, o.threads);
+  }
 
-    ret = o.plugin->rm_dset(dset);
-
-    if (o.verbosity >= 2){
-      printf("%d: delete dset %s (%d)\n", o.rank, dset, ret);
+  if(o.threads == 1){
+    run_phase_thread(phase, s, current_index_p, 0);
+  }else{
+    const size_t slice = thread_slice(s->repeats);
+    worker_t * workers = malloc(sizeof(worker_t) * o.threads);
+    for(int i=0; i < o.threads; i++){
+      worker_t * w = & workers[i];
+      w->id = i;
+      w->phase = phase;
+      w->current_index = *current_index_p;
+      memset(& w->stat, 0, sizeof(phase_stat_t));
+      w->stat.repeats = slice;
+      w->stat.time_create = s->time_create + i * slice;
+      w->stat.time_read = s->time_read + i * slice;
+      w->stat.time_stat = s->time_stat + i * slice;
+      w->stat.time_delete = s->time_delete + i * slice;
+      w->stat.phase_start_timer = s->phase_start_timer;
+      w->stat.writer_ring = i;
+      init_histograms(& w->stat);
+      pthread_create(& w->thread, NULL, worker_main, w);
     }
+    int current_index = *current_index_p;
+    s->repeats = 0;
+    for(int i=0; i < o.threads; i++){
+      worker_t * w = & workers[i];
+      pthread_join(w->thread, NULL);
+      merge_thread_stats(s, & w->stat);
+      free(w->stat.hist_create);
+      free(w->stat.hist_depth);
+      free(w->stat.trace);
+      current_index = w->current_index > current_index ? w->current_index : current_index;
+    }
+    *current_index_p = current_index;
+    free(workers);
+  }
+  timeline_instant(phase_end_names[phase]);
 
-    if (ret == MD_SUCCESS){
-      s->dset_delete.suc++;
-    }else if (ret != MD_NOOP){
-      s->dset_delete.err++;
+  if(interval_report){
+    char file[1024];
+    if(phase == PHASE_BENCHMARK){
+      sprintf(file, "%s-%d-%s.csv", o.heatmap_prefix, global_iteration, phase_names[phase]);
+    }else{
+      sprintf(file, "%s-%s.csv", o.heatmap_prefix, phase_names[phase]);
     }
+    md_interval_finish(interval_report, file);
+    interval_report = NULL;
+  }
+  if(latency_writer){
+    s->writer_blocked = md_lat_writer_stop(latency_writer);
+    latency_writer = NULL;
+  }
+
+  if(phase == PHASE_BENCHMARK && use_mix){
+    working_set += (mix.count[MD_OP_WRITE] - mix.count[MD_OP_DELETE]) * s->mix_iterations;
+  }
+
+  if(phase == PHASE_BENCHMARK && o.stonewall_timer && ! o.stonewall_timer_wear_out){
+    // TODO FIXME
+    int sh = s->stonewall_iterations;
+    int ret = MPI_Allreduce(& sh, & s->stonewall_iterations, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    CHECK_MPI_RET(ret)
   }
 }
 
@@ -850,13 +2979,26 @@ static option_help options [] = {
   {'i', "interface", "The interface (plugin) to use for the test, use list to show all compiled plugins.", OPTION_OPTIONAL_ARGUMENT, 's', & o.interface},
   {'I', "obj-per-proc", "Number of I/O operations per data set.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.num},
   {'L', "latency", "Measure the latency for individual operations, prefix the result files with the provided filename.", OPTION_OPTIONAL_ARGUMENT, 's', & o.latency_file_prefix},
+  {0, "trace-events", "Write all operations of all processes as trace-event JSON into the file, it can be viewed with Perfetto or chrome://tracing", OPTION_OPTIONAL_ARGUMENT, 's', & o.trace_events_file},
+  {0, "mix", "The mix of the operations of the benchmark phase instead of stat, read, delete and create of each object, e.g., stat=70,read=20,create=7,delete=3 (see md_mix.h); -I is the number of iterations of ops operations per data set", OPTION_OPTIONAL_ARGUMENT, 's', & o.mix},
+  {0, "mix-file", "Read the mix of the operations from the file, see --mix", OPTION_OPTIONAL_ARGUMENT, 's', & o.mix_file},
+  {0, "replay", "Replay the trace <prefix>-<rank>.txt of each process instead of the phases, see md_replay.h; the data sets and objects accessed before the trace creates them are created before and the remaining ones are removed after the replay, the time is NOT included; -I * -D is the number of the last operations per type kept as individual latency samples", OPTION_OPTIONAL_ARGUMENT, 's', & o.replay},
+  {0, "replay-speed", "Issue the operations of the replay at the inter-arrival times of the trace scaled by this factor, e.g., 2 replays twice as fast, the latency is measured from the intended start of an operation; 0 replays as fast as possible", OPTION_OPTIONAL_ARGUMENT, 'f', & o.replay_speed},
+  {0, "trace", "Write a binary trace of all operations of each phase into a shared file with the provided prefix, see md-trace-convert; the records are kept in memory until the end of the phase, thus it cannot be combined with --duration", OPTION_OPTIONAL_ARGUMENT, 's', & o.trace_prefix},
   {0, "latency-all", "Keep the latency files from all ranks.", OPTION_FLAG, 'd', & o.latency_keep_all},
+  {0, "latency-exact", "Gather all individual latencies on rank 0 to compute exact statistics instead of using the histograms.", OPTION_FLAG, 'd', & o.latency_exact},
+  {0, "latency-precision", "Number of linear sub-bucket bits per power of two in the latency histograms (1-16), the relative error is below 2^-precision.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.latency_precision},
   {'P', "precreate-per-set", "Number of object to precreate per data set.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.precreate},
   {'D', "data-sets", "Number of data sets covered per process and iteration.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.dset_count},
+  {0, "shared-dsets", "Share the data sets among groups of this number of consecutive processes, 0 for all processes; the leader of a group creates and removes the data sets, the objects of the members are interleaved", OPTION_OPTIONAL_ARGUMENT, 'd', & o.shared_dsets},
+  {0, "tree-depth", "Place the objects of each data set round-robin in a directory tree of this depth below the data set, the directories are created by precreate and removed by cleanup; the latency of the stats is reported per depth, needs plugin support", OPTION_OPTIONAL_ARGUMENT, 'd', & o.tree_depth},
+  {0, "tree-fanout", "The number of subdirectories of each directory of the tree, see --tree-depth", OPTION_OPTIONAL_ARGUMENT, 'd', & o.tree_fanout},
   {'q', "quiet", "Avoid irrelevant printing.", OPTION_FLAG, 'd', & o.quiet_output},
-  {'m', "lim-free-mem", "Allocate memory until this limit (in MiB) is reached.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.limit_memory},
-  {'M', "lim-free-mem-phase", "Allocate memory until this limit (in MiB) is reached between the phases, but free it before starting the next phase; the time is NOT included for the phase.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.limit_memory_between_phases},
+  {'m', "lim-free-mem", "Allocate memory until this limit (in MiB of 1024 KiB, formerly 1000 KiB) of free memory and page cache is reached and keep it during the run, one process per node maintains the limit.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.limit_memory},
+  {0, "lim-free-mem-log", "Log the memory usable for caching and the size of the balloon of -m over time into files with the provided prefix", OPTION_OPTIONAL_ARGUMENT, 's', & o.limit_memory_log},
+  {'M', "lim-free-mem-phase", "Allocate memory until this limit (in MiB of 1024 KiB, formerly 1000 KiB) is reached between the phases, but free it before starting the next phase; the time is NOT included for the phase.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.limit_memory_between_phases},
   {'S', "object-size", "Size for the created objects.", OPTION_OPTIONAL_ARGUMENT, 'd', & o.file_size},
+  {0, "object-size-dist", "The distribution of the object sizes: fixed (-S), uniform:MIN:MAX, lognormal:MEDIAN:SIGMA:MAX or empirical:FILE with lines of the upper bound of a bucket and its weight; the size of each object is derived from its rank, data set and index", OPTION_OPTIONAL_ARGUMENT, 's', & o.size_dist},
   {'R', "iterations", "Number of times to rerun the main phase", OPTION_OPTIONAL_ARGUMENT, 'd', & o.iterations},
   {'t', "waiting-time", "Waiting time relative to runtime (1.0 is 100%%)", OPTION_OPTIONAL_ARGUMENT, 'f', & o.relative_waiting_factor},
   {'T', "adaptive-waiting", "Compute an adaptive waiting time", OPTION_FLAG, 'd', & o.adaptive_waiting_mode},
@@ -865,11 +3007,29 @@ static option_help options [] = {
   {'3', "run-cleanup", "Run cleanup phase (only run explicit phases)", OPTION_FLAG, 'd', & o.phase_cleanup},
   {'w', "stonewall-timer", "Stop each benchmark iteration after the specified seconds (if not used with -W this leads to process-specific progress!)", OPTION_OPTIONAL_ARGUMENT, 'd', & o.stonewall_timer},
   {'W', "stonewall-wear-out", "Stop with stonewall after specified time and use a soft wear-out phase -- all processes perform the same number of iterations", OPTION_FLAG, 'd', & o.stonewall_timer_wear_out},
+  {0, "duration", "Run each benchmark iteration for the specified seconds instead of -I iterations, the precreated objects are recycled in FIFO order; -I is the number of iterations kept as individual latency samples", OPTION_OPTIONAL_ARGUMENT, 'd', & o.duration},
+  {0, "report-interval", "Print the throughput and latency of all processes for each interval of the specified seconds during the phases; the intervals are ended when an operation completes, the intervals spanned by a stalled operation are printed without operations once it completes", OPTION_OPTIONAL_ARGUMENT, 'f', & o.report_interval},
+  {0, "report-heatmap", "Prefix of the latency heatmap files (operations per interval and latency range) written with --report-interval", OPTION_OPTIONAL_ARGUMENT, 's', & o.heatmap_prefix},
   {0, "start-item", "The iteration number of the item to start with, allowing to offset the operations", OPTION_OPTIONAL_ARGUMENT, 'l', & o.start_item_number},
   {0, "print-detailed-stats", "Print detailed machine parsable statistics.", OPTION_FLAG, 'd', & o.print_detailed_stats},
   {0, "read-only", "Run read-only during benchmarking phase (no deletes/writes), probably use with -2", OPTION_FLAG, 'd', & o.read_only},
   {0, "ignore-precreate-errors", "Ignore errors occurring during the pre-creation phase", OPTION_FLAG, 'd', & o.ignore_precreate_errors},
   {0, "process-reports", "Independent report per process/rank", OPTION_FLAG, 'd', & o.process_report},
+  {0, "threads", "Number of threads per process issuing operations, objects are distributed round-robin across the threads; requires a thread-safe plugin", OPTION_OPTIONAL_ARGUMENT, 'd', & o.threads},
+  {0, "queue-depth", "Number of objects with outstanding operations per process during the benchmark phase; requires a plugin with asynchronous interface, otherwise blocking calls are used", OPTION_OPTIONAL_ARGUMENT, 'd', & o.queue_depth},
+  {0, "batch", "Number of objects issued together with the batched interface of the plugin, otherwise one call per object is used; the latency per object is the amortized latency of the batch", OPTION_OPTIONAL_ARGUMENT, 'd', & o.batch},
+  {0, "target-rate", "Open-loop benchmark phase: the operations per second each process issues, the latency is measured from the intended start of an operation", OPTION_OPTIONAL_ARGUMENT, 'f', & o.target_rate},
+  {0, "arena-hugepages", "Allocate the buffers for the measurements on huge pages", OPTION_FLAG, 'd', & o.arena_hugepages},
+  {0, "arena-mlock", "Lock the buffers for the measurements into memory", OPTION_FLAG, 'd', & o.arena_lock},
+  {0, "cache-residency", "Sample this fraction of the objects of each process before and after each phase and report the share of their pages in the cache of the client, needs plugin support; the time is NOT included for the phase", OPTION_OPTIONAL_ARGUMENT, 'f', & o.cache_residency},
+  {0, "cache-policy", "Prepare the caches before each benchmark iteration: warm, evict (the plugin evicts the objects read by the process) or drop (drop the page cache, dentries and inodes of each node, needs privileges); the time is NOT included for the phase", OPTION_OPTIONAL_ARGUMENT, 's', & o.cache_policy},
+  {0, "perf-counters", "Count cycles, instructions, context switches, page faults and CPU migrations of each process during each phase with perf_event_open and report the average per operation; unavailable counters are reported as -, counters the kernel multiplexed are scaled to the full phase and marked (scaled)", OPTION_FLAG, 'd', & o.perf_counters},
+  {0, "perf-counters-ops", "In addition, read the counters around each operation of the benchmark phase and report them per operation type; this adds system calls to each operation, but not to its latency", OPTION_FLAG, 'd', & o.perf_counters_ops},
+  {0, "cpu-time", "Measure the CPU time of each synchronous operation of the issuing thread and report the CPU time per operation and its share of the wall time per operation type, and the user and system CPU time of the phases; the CPU time includes reading the CPU clock", OPTION_FLAG, 'd', & o.cpu_time},
+  {0, "timer", "The source of the timers: monotonic, monotonic-raw or tsc (the invariant time stamp counter)", OPTION_OPTIONAL_ARGUMENT, 's', & o.timer_source},
+  {0, "timer-subtract-overhead", "Subtract the measured overhead of reading the timer from each latency", OPTION_FLAG, 'd', & o.timer_subtract_overhead},
+  {0, "arrival", "The inter-arrival times for --target-rate: poisson or constant", OPTION_OPTIONAL_ARGUMENT, 's', & o.arrival},
+  {0, "deadline-tolerance", "The seconds an operation of --target-rate or --replay-speed may start after its intended start without counting as a missed deadline, at least the resolution of the timer", OPTION_OPTIONAL_ARGUMENT, 'f', & o.deadline_tolerance},
   {'v', "verbose", "Increase the verbosity level", OPTION_FLAG, 'd', & o.verbosity},
   {0, "run-info-file", "The log file for resuming a previous run", OPTION_OPTIONAL_ARGUMENT, 's', & o.run_info_file},
   LAST_OPTION
@@ -915,6 +3075,7 @@ static void printTime(){
     printf("%s\n", buff);
 }
 
+// the position and, with --mix, the size of the working set
 static int return_position(){
   int position, ret;
   if( o.rank == 0){
@@ -923,14 +3084,15 @@ static int return_position(){
       printf("[ERROR] Could not open %s for restart\n", o.run_info_file);
       exit(1);
     }
-    ret = fscanf(f, "pos: %d", & position);
-    if (ret != 1){
+    ret = fscanf(f, "pos: %d\nsize: %d", & position, & working_set);
+    if (ret < 1){
       printf("Could not read from %s for restart\n", o.run_info_file);
       exit(1);
     }
     fclose(f);
   }
   ret = MPI_Bcast( & position, 1, MPI_INT, 0, MPI_COMM_WORLD );
+  ret = MPI_Bcast( & working_set, 1, MPI_INT, 0, MPI_COMM_WORLD );
   return position;
 }
 
@@ -944,17 +3106,51 @@ static void store_position(int position){
     exit(1);
   }
   fprintf(f, "pos: %d\n", position);
+  if(use_mix){
+    fprintf(f, "size: %d\n", working_set);
+  }
   fclose(f);
 }
 
+static void prepare_global(){
+  if (o.rank == 0){
+    int ret = o.plugin->prepare_global();
+    if ( ret != MD_SUCCESS && ret != MD_NOOP ){
+      if ( ! (ret == MD_EXISTS && o.ignore_precreate_errors)){
+        printf("Rank 0 could not prepare the run, aborting\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+  }
+}
+
+static void purge_global(){
+  if (o.rank == 0){
+    int ret = o.plugin->purge_global();
+    if (ret != MD_SUCCESS && ret != MD_NOOP){
+      printf("Rank 0: Error purging the global environment\n");
+    }
+  }
+}
+
+// the writer thread of --trace-events issues MPI calls, the options are parsed after MPI_Init_thread()
+static int needs_thread_multiple(int argc, char ** argv){
+  for(int i=1; i < argc && strcmp(argv[i], "--") != 0; i++){
+    if(strncmp(argv[i], "--trace-events", 14) == 0){
+      return 1;
+    }
+  }
+  return 0;
+}
+
 int main(int argc, char ** argv){
   int ret;
   int printhelp = 0;
-  char * limit_memory_P = NULL;
-
   init_options();
 
-  MPI_Init(& argc, & argv);
+  int provided;
+  // only the main thread issues MPI calls, see --threads, except for the writer thread of --trace-events
+  MPI_Init_thread(& argc, & argv, needs_thread_multiple(argc, argv) ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED, & provided);
   MPI_Comm_rank(MPI_COMM_WORLD, & o.rank);
   MPI_Comm_size(MPI_COMM_WORLD, & o.size);
 
@@ -999,6 +3195,236 @@ int main(int argc, char ** argv){
     exit(1);
   }
 
+  if (o.duration < 0 || (o.duration > 0 && (o.precreate < 1 || o.read_only || o.stonewall_timer || o.threads > 1 || o.queue_depth > 1 || o.batch > 1 || o.trace_prefix))){
+    if(o.rank == 0)
+      printf("Invalid options, the duration must not be negative, needs precreated objects and cannot be combined with --read-only, -w, --threads, --queue-depth, --batch or --trace\n");
+    exit(1);
+  }
+  if (o.duration > 0){
+    // the progress is exchanged independently of the other collectives, see pacing_progress()
+    MPI_Comm_dup(MPI_COMM_WORLD, & pacing_comm);
+  }
+
+  if (o.latency_precision < MD_HIST_MIN_PRECISION || o.latency_precision > MD_HIST_MAX_PRECISION){
+    if(o.rank == 0)
+      printf("Invalid options, the latency precision must be between %d and %d\n", MD_HIST_MIN_PRECISION, MD_HIST_MAX_PRECISION);
+    exit(1);
+  }
+  md_hist_mpi_init(o.latency_precision, & hist_type, & hist_op);
+
+  if (o.report_interval < 0 || (o.report_interval > 0 && o.threads > 1)){
+    if(o.rank == 0)
+      printf("Invalid options, the report interval must not be negative and cannot be combined with --threads\n");
+    exit(1);
+  }
+  if (o.report_interval > 0){
+    // the interval reductions are issued independently of the other collectives
+    MPI_Comm_dup(MPI_COMM_WORLD, & interval_comm);
+  }
+  if (o.trace_events_file && (o.threads > 1 || provided < MPI_THREAD_MULTIPLE)){
+    if(o.rank == 0)
+      printf("Invalid options, the trace events cannot be combined with --threads and need an MPI library with MPI_THREAD_MULTIPLE\n");
+    exit(1);
+  }
+  if (o.mix || o.mix_file){
+    char err[1024];
+    if((o.mix && o.mix_file) || (o.mix ? md_mix_parse(& mix, o.mix, err) : md_mix_load(& mix, o.mix_file, err)) != 0){
+      if(o.rank == 0)
+        printf("Invalid options, the mix is invalid: %s\n", o.mix && o.mix_file ? "use either --mix or --mix-file" : err);
+      exit(1);
+    }
+    if(o.read_only || o.duration || o.queue_depth > 1 || o.batch > 1){
+      if(o.rank == 0)
+        printf("Invalid options, the mix cannot be combined with --read-only, --duration, --queue-depth or --batch\n");
+      exit(1);
+    }
+    use_mix = 1;
+  }
+  working_set = o.precreate;
+  {
+    char err[1024];
+    if(o.file_size < 0 || md_size_dist_parse(& size_dist, o.size_dist ? o.size_dist : "fixed", o.file_size, err) != 0 || md_size_dist_max(& size_dist) > UINT32_MAX){
+      if(o.rank == 0)
+        printf("Invalid options, the object size distribution is invalid: %s\n", o.file_size < 0 ? "negative size" : err);
+      exit(1);
+    }
+  }
+  if (o.perf_counters_ops){
+    if(o.threads > 1 || o.queue_depth > 1 || o.batch > 1){
+      if(o.rank == 0)
+        printf("Invalid options, the counters per operation cannot be combined with --threads, --queue-depth or --batch\n");
+      exit(1);
+    }
+    o.perf_counters = 1;
+  }
+
+  if (o.threads < 1){
+    if(o.rank == 0)
+      printf("Invalid options, the number of threads must be at least 1\n");
+    exit(1);
+  }
+  // without MPI_THREAD_FUNNELED the library does not allow any other thread in the process
+  if (provided < MPI_THREAD_FUNNELED && (o.threads > 1 || o.limit_memory || (o.latency_file_prefix && ! o.latency_keep_all))){
+    if(o.rank == 0)
+      printf("Invalid options, the MPI library does not support threads, thus --threads, -m and -L without --latency-all cannot be used\n");
+    exit(1);
+  }
+  if (o.threads > 1){
+    if (! o.plugin->thread_safe){
+      if(o.rank == 0)
+        printf("Invalid options, the plugin %s is not thread-safe and cannot be used with --threads\n", o.plugin->name);
+      exit(1);
+    }
+    // each thread would stop at its own iteration, leaving gaps in the objects of the other threads
+    if (o.stonewall_timer || o.stonewall_timer_wear_out){
+      if(o.rank == 0)
+        printf("Invalid options, the stonewall cannot be combined with --threads\n");
+      exit(1);
+    }
+    pthread_barrier_init(& thread_barrier, NULL, o.threads);
+  }
+  if (o.queue_depth < 1){
+    if(o.rank == 0)
+      printf("Invalid options, the queue depth must be at least 1\n");
+    exit(1);
+  }
+  if (o.queue_depth > 1){
+    if (o.threads > 1 || o.stonewall_timer_wear_out || o.relative_waiting_factor > 1e-9 || o.adaptive_waiting_mode){
+      if(o.rank == 0)
+        printf("Invalid options, the queue depth cannot be combined with --threads, stonewall wear-out or waiting\n");
+      exit(1);
+    }
+    if (! o.plugin->submit_op && o.rank == 0){
+      printf("WARNING: the plugin %s does not support asynchronous operations, using the blocking interface\n", o.plugin->name);
+    }
+  }
+  if (o.batch < 1){
+    if(o.rank == 0)
+      printf("Invalid options, the batch size must be at least 1\n");
+    exit(1);
+  }
+  if (o.batch > 1 && (o.queue_depth > 1 || o.stonewall_timer_wear_out)){
+    if(o.rank == 0)
+      printf("Invalid options, the batch size cannot be combined with the queue depth or stonewall wear-out\n");
+    exit(1);
+  }
+  if (strcmp(o.arrival, "poisson") == 0){
+    o.arrival_poisson = 1;
+  }else if (strcmp(o.arrival, "constant") != 0){
+    if(o.rank == 0)
+      printf("Invalid options, the arrival must be poisson or constant\n");
+    exit(1);
+  }
+  {
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, o.rank, MPI_INFO_NULL, & node_comm);
+    MPI_Comm_rank(node_comm, & node_rank);
+    MPI_Comm_free(& node_comm);
+  }
+  o.cache_policy_id = -1;
+  for(int i=0; i < 3; i++){
+    if(strcmp(o.cache_policy, cache_policy_names[i]) == 0){
+      o.cache_policy_id = i;
+    }
+  }
+  if (o.cache_policy_id < 0 || (o.cache_policy_id == CACHE_EVICT && ! o.plugin->evict_obj) || (o.cache_policy_id == CACHE_DROP && access("/proc/sys/vm/drop_caches", W_OK) != 0)){
+    if(o.rank == 0)
+      printf("Invalid options, the cache policy must be warm, evict (if supported by the plugin) or drop (with the permission to write /proc/sys/vm/drop_caches)\n");
+    exit(1);
+  }
+  if (o.cache_residency < 0 || o.cache_residency > 1 || (o.cache_residency > 0 && ! o.plugin->obj_residency)){
+    if(o.rank == 0)
+      printf("Invalid options, the cache residency must be a fraction between 0 and 1 and requires the support of the plugin\n");
+    exit(1);
+  }
+  {
+    const int source = timer_source_parse(o.timer_source);
+    if(source < 0 || timer_init((md_timer_source) source) != 0){
+      if(o.rank == 0)
+        printf("Invalid options, the timer must be monotonic, monotonic-raw or tsc with an invariant time stamp counter\n");
+      exit(1);
+    }
+    o.timer_overhead = (uint64_t) timer_overhead_ns();
+  }
+  if (o.deadline_tolerance < 0){
+    if(o.rank == 0)
+      printf("Invalid options, the deadline tolerance must not be negative\n");
+    exit(1);
+  }
+  if (o.deadline_tolerance < timer_resolution_ns() * 1e-9){
+    // a start within the resolution of the timer cannot be told apart from the intended one
+    o.deadline_tolerance = timer_resolution_ns() * 1e-9;
+  }
+  if (o.target_rate < 0){
+    if(o.rank == 0)
+      printf("Invalid options, the target rate must not be negative\n");
+    exit(1);
+  }
+  if (o.target_rate > 0 && (o.queue_depth > 1 || o.batch > 1 || o.relative_waiting_factor > 1e-9 || o.adaptive_waiting_mode)){
+    if(o.rank == 0)
+      printf("Invalid options, the target rate cannot be combined with the queue depth, batches or waiting\n");
+    exit(1);
+  }
+
+  if (o.shared_dsets < 0 || (o.shared_dsets != 1 && (o.threads > 1 || o.replay))){
+    if(o.rank == 0)
+      printf("Invalid options, the number of processes sharing the data sets must not be negative and sharing cannot be combined with --threads or --replay\n");
+    exit(1);
+  }
+  if (o.shared_dsets == 0 || o.shared_dsets > o.size){
+    o.shared_dsets = o.size;
+  }
+  if (o.shared_dsets > 1){
+    // the interleaved object indices of a group must fit into the int of the plugins, see define_obj_name()
+    const int64_t runs = (int64_t) o.iterations * (o.adaptive_waiting_mode ? 8 : 1);
+    const int64_t objects = (int64_t) o.start_item_number + o.precreate + runs * o.num * (use_mix ? mix.count[MD_OP_WRITE] : 1);
+    if (objects * o.shared_dsets > INT_MAX){
+      if(o.rank == 0)
+        printf("Invalid options, the %lld objects per process of a group of %d processes exceed the object indices of the plugins\n", (long long) objects, o.shared_dsets);
+      exit(1);
+    }
+    MPI_Comm_split(MPI_COMM_WORLD, shared_leader(o.rank), o.rank, & shared_comm);
+  }
+
+  if (o.tree_depth < 0 || o.tree_depth > MAX_TREE_DEPTH || o.tree_fanout < 1 || (o.tree_depth > 0 && (! o.plugin->def_subdir_name || ! o.plugin->def_subdir_obj_name || o.replay))){
+    if(o.rank == 0)
+      printf("Invalid options, the tree depth must be between 0 and %d with a fanout of at least 1, it requires the support of the plugin and cannot be combined with --replay\n", MAX_TREE_DEPTH);
+    exit(1);
+  }
+  for(int depth=0; depth < o.tree_depth; depth++){
+    const int64_t width = (int64_t) tree_first[depth + 1] - tree_first[depth];
+    if(tree_first[depth + 1] + width * o.tree_fanout > (1 << 24)){
+      if(o.rank == 0)
+        printf("Invalid options, the tree has more than %d directories per data set\n", 1 << 24);
+      exit(1);
+    }
+    tree_first[depth + 2] = tree_first[depth + 1] + (int) (width * o.tree_fanout);
+  }
+  tree_nodes = tree_first[o.tree_depth + 1];
+
+  if (o.replay){
+    if (o.replay_speed < 0 || use_mix || o.duration || o.threads > 1 || o.queue_depth > 1 || o.batch > 1 || o.target_rate > 0 || o.read_only || o.stonewall_timer || o.relative_waiting_factor > 1e-9 || o.adaptive_waiting_mode || o.cache_residency > 0 || o.cache_policy_id == CACHE_EVICT){
+      if(o.rank == 0)
+        printf("Invalid options, the replay speed must not be negative and the replay cannot be combined with --mix, --duration, --threads, --queue-depth, --batch, --target-rate, --read-only, -w, waiting, --cache-residency or the cache policy evict\n");
+      exit(1);
+    }
+    char file[1024];
+    char err[1024];
+    sprintf(file, "%s-%d.txt", o.replay, o.rank);
+    replay = md_replay_open(file, err);
+    const int failed = replay == NULL;
+    int any_failed;
+    MPI_Allreduce(& failed, & any_failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if(failed){
+      printf("Invalid options, the trace cannot be replayed: %s\n", err);
+    }
+    if(any_failed){
+      exit(1);
+    }
+    // the trace replaces the phases
+    o.phase_precreate = o.phase_benchmark = o.phase_cleanup = 0;
+  }
+
   ret = o.plugin->initialize();
   if (ret != MD_SUCCESS){
     printf("%d: Error initializing module\n", o.rank);
@@ -1016,11 +3442,48 @@ int main(int argc, char ** argv){
     current_index = o.start_item_number;
   }
 
+  if(use_mix && o.phase_benchmark){
+    // the objects of a phase must not be deleted before they are read
+    const int runs = o.iterations * (o.adaptive_waiting_mode ? 8 : 1);
+    const int last = working_set + (mix.count[MD_OP_WRITE] - mix.count[MD_OP_DELETE]) * o.num * (runs - 1);
+    const int reads = mix.count[MD_OP_STAT] + mix.count[MD_OP_READ] > 0 ? 1 : 0;
+    if(mix.count[MD_OP_DELETE] * o.num + reads > (last < working_set ? last : working_set)){
+      if(o.rank == 0)
+        printf("Invalid options, the mix deletes more objects per benchmark phase than the working set of %d objects per data set keeps for reading, increase -P or reduce -I\n", working_set);
+      exit(1);
+    }
+  }
+
+  // the page faults of the measurement buffers are not part of the timed phases
+  if(arena_init() != 0){
+    printf("%d: Error allocating %zu bytes for the measurements\n", o.rank, arena.size);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
   size_t total_obj_count = o.dset_count * (size_t) (o.num * o.iterations + o.precreate) * o.size;
   if (o.rank == 0 && ! o.quiet_output){
-    printf("MD-Workbench total objects: %zu workingset size: %.3f MiB (version: %s) time: ", total_obj_count, ((double) o.size) * o.dset_count * o.precreate * o.file_size / 1024.0 / 1024.0,  VERSION);
+    printf("MD-Workbench total objects: %zu workingset size: %.3f MiB (version: %s) time: ", total_obj_count, ((double) o.size) * o.dset_count * o.precreate * md_size_dist_mean(& size_dist) / 1024.0 / 1024.0,  VERSION);
     printTime();
-    if(o.num > o.precreate){
+    printf("Measurement buffers: %.3f MiB per process, %.3f MiB on rank 0\n", 4.0 * arena.process_count * sizeof(time_result_t) / 1024 / 1024, arena.size / 1024.0 / 1024);
+    printf("Cache policy: %s\n", o.cache_policy);
+    if(o.size_dist){
+      char size_desc[1024];
+      md_size_dist_print(& size_dist, size_desc);
+      printf("Object sizes: %s\n", size_desc);
+    }
+    if(o.shared_dsets > 1){
+      printf("Shared data sets: groups of %d processes\n", o.shared_dsets);
+    }
+    if(o.tree_depth > 0){
+      printf("Tree: depth:%d fanout:%d directories per data set:%d\n", o.tree_depth, o.tree_fanout, tree_nodes - 1);
+    }
+    if(use_mix){
+      char mix_desc[1024];
+      md_mix_print(& mix, mix_desc);
+      printf("Mix: %s\n", mix_desc);
+    }
+    printf("Timer: %s overhead:%.1fns resolution:%.1fns%s\n", timer_source_name(), timer_overhead_ns(), timer_resolution_ns(), o.timer_subtract_overhead ? " (subtracted)" : "");
+    if(o.num > o.precreate && ! o.duration && ! use_mix){
       printf("WARNING: num > precreate, this may cause the situation that no objects are available to read\n");
     }
   }
@@ -1034,11 +3497,37 @@ int main(int argc, char ** argv){
     printf("\n");
   }
 
-  // preallocate memory if necessary
-  ret = mem_preallocate(& limit_memory_P, o.limit_memory, o.verbosity >= 3);
-  if(ret != 0){
-    printf("%d: Error allocating memory\n", o.rank);
-    MPI_Abort(MPI_COMM_WORLD, 1);
+  // limit the memory usable for caching on each node during the run
+  mem_balloon_t * balloon = NULL;
+  if(o.limit_memory){
+    if(node_rank == 0){
+      char log_file[1024];
+      if(o.limit_memory_log){
+        sprintf(log_file, "%s-%d.csv", o.limit_memory_log, o.rank);
+      }
+      balloon = mem_balloon_start(o.limit_memory, 0.1, 1, o.limit_memory_log ? log_file : NULL);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  if(o.trace_events_file){
+    timeline = md_timeline_open(o.trace_events_file, MPI_COMM_WORLD);
+    if(timeline == NULL){
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+
+  // opened after the threads of the harness are started, the worker threads of the phases are included
+  if(o.perf_counters){
+    const int available = md_perf_open(& perf_counters);
+    MPI_Allreduce(& available, & perf_available, 1, MPI_INT, MPI_BAND, MPI_COMM_WORLD);
+    if(o.rank == 0 && ! o.quiet_output){
+      printf("Perf counters:");
+      for(int i=0; i < MD_PC_COUNT; i++){
+        printf(" %s%s", md_perf_counter_names[i], (perf_available & (1 << i)) ? "" : "(unavailable)");
+      }
+      printf("%s\n", perf_counters.user_only ? " user space only" : "");
+    }
   }
 
   timer bench_start;
@@ -1050,22 +3539,17 @@ int main(int argc, char ** argv){
   }
 
   if (o.phase_precreate){
-    if (o.rank == 0){
-      ret = o.plugin->prepare_global();
-      if ( ret != MD_SUCCESS && ret != MD_NOOP ){
-        if ( ! (ret == MD_EXISTS && o.ignore_precreate_errors)){
-          printf("Rank 0 could not prepare the run, aborting\n");
-          MPI_Abort(MPI_COMM_WORLD, 1);
-        }
-      }
-    }
-    init_stats(& phase_stats, o.precreate * o.dset_count);
+    prepare_global();
+    init_stats(& phase_stats, o.precreate * o.dset_count, arena.process, arena.process_count);
     MPI_Barrier(MPI_COMM_WORLD);
 
     // pre-creation phase
+    phase_counters_start(& phase_stats);
     start_timer(& phase_stats.phase_start_timer);
-    run_precreate(& phase_stats, current_index);
+    run_phase(PHASE_PRECREATE, & phase_stats, & current_index);
     phase_stats.t = stop_timer(phase_stats.phase_start_timer);
+    phase_counters_stop(& phase_stats);
+    sample_residency(& phase_stats.cache_after, current_index);
     end_phase("precreate", & phase_stats);
   }
 
@@ -1075,19 +3559,33 @@ int main(int argc, char ** argv){
       if(o.adaptive_waiting_mode){
         o.relative_waiting_factor = 0;
       }
-      init_stats(& phase_stats, o.num * o.dset_count);
+      init_stats(& phase_stats, o.num * o.dset_count, arena.process, arena.process_count);
+      evict_cache(current_index);
+      sample_residency(& phase_stats.cache_before, current_index);
+      sample_read_residency(& phase_stats.cache_read, current_index);
+      prepare_benchmark(current_index);
       MPI_Barrier(MPI_COMM_WORLD);
+      phase_counters_start(& phase_stats);
       start_timer(& phase_stats.phase_start_timer);
-      run_benchmark(& phase_stats, & current_index);
+      run_phase(PHASE_BENCHMARK, & phase_stats, & current_index);
+      phase_counters_stop(& phase_stats);
+      sample_residency(& phase_stats.cache_after, current_index);
       end_phase("benchmark", & phase_stats);
 
       if(o.adaptive_waiting_mode){
         o.relative_waiting_factor = 0.0625;
         for(int r=0; r <= 6; r++){
-          init_stats(& phase_stats, o.num * o.dset_count);
+          init_stats(& phase_stats, o.num * o.dset_count, arena.process, arena.process_count);
+          evict_cache(current_index);
+          sample_residency(& phase_stats.cache_before, current_index);
+          sample_read_residency(& phase_stats.cache_read, current_index);
+          prepare_benchmark(current_index);
           MPI_Barrier(MPI_COMM_WORLD);
+          phase_counters_start(& phase_stats);
           start_timer(& phase_stats.phase_start_timer);
-          run_benchmark(& phase_stats, & current_index);
+          run_phase(PHASE_BENCHMARK, & phase_stats, & current_index);
+          phase_counters_stop(& phase_stats);
+          sample_residency(& phase_stats.cache_after, current_index);
           end_phase("benchmark", & phase_stats);
           o.relative_waiting_factor *= 2;
         }
@@ -1097,22 +3595,40 @@ int main(int argc, char ** argv){
 
   // cleanup phase
   if (o.phase_cleanup){
-    init_stats(& phase_stats, o.precreate * o.dset_count);
+    init_stats(& phase_stats, working_set * o.dset_count, arena.process, arena.process_count);
+    sample_residency(& phase_stats.cache_before, current_index);
+    phase_counters_start(& phase_stats);
     start_timer(& phase_stats.phase_start_timer);
-    run_cleanup(& phase_stats, current_index);
+    run_phase(PHASE_CLEANUP, & phase_stats, & current_index);
     phase_stats.t = stop_timer(phase_stats.phase_start_timer);
+    phase_counters_stop(& phase_stats);
     end_phase("cleanup", & phase_stats);
-
-    if (o.rank == 0){
-      ret = o.plugin->purge_global();
-      if (ret != MD_SUCCESS && ret != MD_NOOP){
-        printf("Rank 0: Error purging the global environment\n");
-      }
-    }
-  }else{
+    purge_global();
+  }else if (! replay){
     store_position(current_index);
   }
 
+  if (replay){
+    prepare_global();
+    MPI_Barrier(MPI_COMM_WORLD);
+    replay_prepare();
+    init_stats(& phase_stats, o.num * o.dset_count, arena.process, arena.process_count);
+    evict_cache(current_index);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    phase_counters_start(& phase_stats);
+    start_timer(& phase_stats.phase_start_timer);
+    run_phase(PHASE_REPLAY, & phase_stats, & current_index);
+    phase_stats.t = stop_timer(phase_stats.phase_start_timer);
+    phase_counters_stop(& phase_stats);
+    end_phase("replay", & phase_stats);
+
+    replay_remove();
+    MPI_Barrier(MPI_COMM_WORLD);
+    purge_global();
+    md_replay_close(replay);
+  }
+
   double t_all = stop_timer(bench_start);
   ret = o.plugin->finalize();
   if (ret != MD_SUCCESS){
@@ -1123,7 +3639,36 @@ int main(int argc, char ** argv){
     printTime();
   }
 
-  mem_free_preallocated(& limit_memory_P);
+  if (timeline){
+    md_timeline_close(timeline);
+  }
+  if (o.perf_counters){
+    md_perf_close(& perf_counters);
+  }
+  if (schedules){
+    for(int t=0; t < o.threads; t++){
+      schedule_free(& schedules[t]);
+    }
+    free(schedules);
+  }
+  if (balloon){
+    mem_balloon_stop(balloon, o.rank == 0 && ! o.quiet_output);
+  }
+  mem_arena_free(arena.mem, arena.size);
+  md_size_dist_free(& size_dist);
+  md_hist_mpi_free(& hist_type, & hist_op);
+  if (o.duration > 0){
+    MPI_Comm_free(& pacing_comm);
+  }
+  if (o.report_interval > 0){
+    MPI_Comm_free(& interval_comm);
+  }
+  if (o.threads > 1){
+    pthread_barrier_destroy(& thread_barrier);
+  }
+  if (shared_comm != MPI_COMM_NULL){
+    MPI_Comm_free(& shared_comm);
+  }
 
   MPI_Finalize();
   return 0;
@@ -0,0 +1,154 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <string.h>
+#include <assert.h>
+
+#include <md_histogram.h>
+
+// values up to 2^48 ns (about 78 hours) are distinguished, larger values go into the last bucket
+#define MAX_VALUE_BITS MD_HIST_LOG2_BUCKETS
+
+static uint32_t bucket_count(int precision){
+  const uint32_t sub = 1u << precision;
+  return sub + (MAX_VALUE_BITS - precision) * (sub / 2);
+}
+
+size_t md_hist_size(int precision){
+  return sizeof(md_histogram_t) + bucket_count(precision) * sizeof(uint64_t);
+}
+
+void md_hist_init(md_histogram_t * h, int precision){
+  assert(precision >= MD_HIST_MIN_PRECISION && precision <= MD_HIST_MAX_PRECISION);
+  h->precision = precision;
+  h->bucket_count = bucket_count(precision);
+  md_hist_reset(h);
+}
+
+void md_hist_reset(md_histogram_t * h){
+  h->count = 0;
+  h->min = UINT64_MAX;
+  h->max = 0;
+  memset(h->counts, 0, h->bucket_count * sizeof(uint64_t));
+}
+
+static inline uint32_t bucket_index(const md_histogram_t * h, uint64_t value){
+  const uint64_t sub = 1llu << h->precision;
+  if(value < sub){
+    return (uint32_t) value;
+  }
+  const int msb = 63 - __builtin_clzll(value);
+  const int shift = msb - h->precision + 1;
+  if(msb >= MAX_VALUE_BITS){
+    return h->bucket_count - 1;
+  }
+  return (uint32_t) (sub + (shift - 1) * (sub / 2) + ((value >> shift) - sub / 2));
+}
+
+// the mid of the value range covered by the bucket
+static uint64_t bucket_value(const md_histogram_t * h, uint32_t index){
+  const uint64_t sub = 1llu << h->precision;
+  if(index < sub){
+    return index;
+  }
+  const uint64_t k = index - sub;
+  const int shift = (int) (k / (sub / 2)) + 1;
+  const uint64_t mantissa = k % (sub / 2) + sub / 2;
+  return (mantissa << shift) + ((1llu << shift) - 1) / 2;
+}
+
+void md_hist_add(md_histogram_t * h, uint64_t value){
+  h->counts[bucket_index(h, value)]++;
+  h->count++;
+  if(value < h->min){
+    h->min = value;
+  }
+  if(value > h->max){
+    h->max = value;
+  }
+}
+
+void md_hist_merge(md_histogram_t * into, const md_histogram_t * from){
+  assert(into->precision == from->precision);
+  if(from->count == 0){
+    return;
+  }
+  for(uint32_t i = 0; i < from->bucket_count; i++){
+    into->counts[i] += from->counts[i];
+  }
+  into->count += from->count;
+  into->min = from->min < into->min ? from->min : into->min;
+  into->max = from->max > into->max ? from->max : into->max;
+}
+
+uint64_t md_hist_value_at(const md_histogram_t * h, uint64_t pos){
+  if(h->count == 0){
+    return 0;
+  }
+  if(pos == 0){
+    return h->min;
+  }
+  if(pos >= h->count - 1){
+    return h->max;
+  }
+  uint64_t seen = 0;
+  for(uint32_t i = 0; i < h->bucket_count; i++){
+    seen += h->counts[i];
+    if(seen > pos){
+      uint64_t value = bucket_value(h, i);
+      value = value < h->min ? h->min : value;
+      return value > h->max ? h->max : value;
+    }
+  }
+  return h->max;
+}
+
+void md_hist_log2_counts(const md_histogram_t * h, uint64_t * out){
+  memset(out, 0, MD_HIST_LOG2_BUCKETS * sizeof(uint64_t));
+  for(uint32_t i = 0; i < h->bucket_count; i++){
+    if(h->counts[i] == 0){
+      continue;
+    }
+    const uint64_t value = bucket_value(h, i);
+    int msb = value == 0 ? 0 : 63 - __builtin_clzll(value);
+    msb = msb < MD_HIST_LOG2_BUCKETS ? msb : MD_HIST_LOG2_BUCKETS - 1;
+    out[msb] += h->counts[i];
+  }
+}
+
+static void mpi_hist_merge(void * in, void * inout, int * len, MPI_Datatype * type){
+  char * in_p = (char*) in;
+  char * inout_p = (char*) inout;
+  for(int i=0; i < *len; i++){
+    md_histogram_t * from = (md_histogram_t*) in_p;
+    const size_t size = md_hist_size(from->precision);
+    md_hist_merge((md_histogram_t*) inout_p, from);
+    in_p += size;
+    inout_p += size;
+  }
+}
+
+void md_hist_mpi_init(int precision, MPI_Datatype * out_type, MPI_Op * out_op){
+  MPI_Type_contiguous((int) md_hist_size(precision), MPI_BYTE, out_type);
+  MPI_Type_commit(out_type);
+  MPI_Op_create(mpi_hist_merge, 1, out_op);
+}
+
+void md_hist_mpi_free(MPI_Datatype * type, MPI_Op * op){
+  MPI_Op_free(op);
+  MPI_Type_free(type);
+}
@@ -0,0 +1,69 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_HISTOGRAM_H
+#define MD_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mpi.h>
+
+/*
+ A fixed-size log-linear histogram for latencies in nanoseconds.
+ Values below 2^precision are counted exactly, above each power of two is split
+ into 2^(precision-1) linear sub-buckets, i.e., the relative error is below 2^-precision.
+ The size depends only on the precision, so histograms of all processes can be merged
+ with a single reduction, independent of the number of recorded operations.
+*/
+typedef struct{
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint32_t precision;
+  uint32_t bucket_count;
+  uint64_t counts[];
+} md_histogram_t;
+
+#define MD_HIST_MIN_PRECISION 1
+#define MD_HIST_MAX_PRECISION 16
+
+// the size in bytes of a single histogram with the given precision
+size_t md_hist_size(int precision);
+
+// initialize memory of md_hist_size() bytes
+void md_hist_init(md_histogram_t * h, int precision);
+void md_hist_reset(md_histogram_t * h);
+
+void md_hist_add(md_histogram_t * h, uint64_t value);
+void md_hist_merge(md_histogram_t * into, const md_histogram_t * from);
+
+// return the value of the element at the position (0 <= pos < count) if all values were sorted
+uint64_t md_hist_value_at(const md_histogram_t * h, uint64_t pos);
+
+// the number of power of two ranges covered by a histogram
+#define MD_HIST_LOG2_BUCKETS 48
+
+// count the values per power of two range, out[i] is the number of values in [2^i, 2^(i+1)) ns, out[0] includes 0
+// the array must have MD_HIST_LOG2_BUCKETS elements
+void md_hist_log2_counts(const md_histogram_t * h, uint64_t * out);
+
+// create a contiguous MPI datatype for one histogram and the commutative merge operation
+void md_hist_mpi_init(int precision, MPI_Datatype * out_type, MPI_Op * out_op);
+void md_hist_mpi_free(MPI_Datatype * type, MPI_Op * op);
+
+#endif
@@ -0,0 +1,183 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <md_util.h>
+#include <md_histogram.h>
+#include <md_interval.h>
+
+// an interval whose reduction has been started
+typedef struct{
+  MPI_Request request;
+  md_histogram_t * send;
+  md_histogram_t * recv; // only on rank 0
+  double start;
+  double end;
+} interval_t;
+
+struct md_interval{
+  const char * name;
+  double interval;
+  timer start_timer;
+  double start; // the start of the current interval in seconds since md_interval_init()
+  int precision;
+  int rank;
+  MPI_Comm comm;
+  MPI_Datatype type;
+  MPI_Op op;
+
+  md_histogram_t * current;
+
+  interval_t * intervals;
+  int count; // the number of ended intervals
+  int completed; // the number of intervals with a completed reduction
+  int capacity;
+
+  uint64_t * heatmap; // rank 0: MD_HIST_LOG2_BUCKETS counts per interval
+};
+
+static md_histogram_t * new_histogram(int precision){
+  md_histogram_t * h = malloc(md_hist_size(precision));
+  md_hist_init(h, precision);
+  return h;
+}
+
+md_interval_t * md_interval_init(const char * name, double interval, int precision, MPI_Comm comm, MPI_Datatype type, MPI_Op op){
+  md_interval_t * r = malloc(sizeof(md_interval_t));
+  memset(r, 0, sizeof(md_interval_t));
+  r->name = name;
+  r->interval = interval;
+  r->precision = precision;
+  r->comm = comm;
+  r->type = type;
+  r->op = op;
+  MPI_Comm_rank(comm, & r->rank);
+  start_timer(& r->start_timer);
+  r->current = new_histogram(precision);
+  return r;
+}
+
+void md_interval_add(md_interval_t * r, uint64_t value){
+  md_hist_add(r->current, value);
+}
+
+static void end_interval(md_interval_t * r, double end){
+  if(r->count == r->capacity){
+    r->capacity = r->capacity == 0 ? 64 : r->capacity * 2;
+    r->intervals = realloc(r->intervals, sizeof(interval_t) * r->capacity);
+    if(r->rank == 0){
+      r->heatmap = realloc(r->heatmap, sizeof(uint64_t) * MD_HIST_LOG2_BUCKETS * r->capacity);
+    }
+  }
+  interval_t * i = & r->intervals[r->count++];
+  i->start = r->start;
+  i->end = end;
+  i->send = r->current;
+  i->recv = r->rank == 0 ? new_histogram(r->precision) : NULL;
+  MPI_Ireduce(i->send, i->recv, 1, r->type, r->op, 0, r->comm, & i->request);
+
+  r->current = new_histogram(r->precision);
+  r->start = end;
+}
+
+static void print_interval(md_interval_t * r, int index, interval_t * i){
+  md_histogram_t * h = i->recv;
+  const double t = i->end - i->start;
+  printf("%s interval:%d time:%.1fs ops:%llu rate:%.1f iops/s", r->name, index, i->end, (long long unsigned) h->count, t > 0 ? h->count / t : 0.0);
+  if(h->count > 0){
+    printf(" latency(%.4es, %.4es, %.4es, %.4es, %.4es)",
+      h->min / 1e9,
+      md_hist_value_at(h, h->count / 2) / 1e9,
+      md_hist_value_at(h, (uint64_t) (h->count * 0.90)) / 1e9,
+      md_hist_value_at(h, (uint64_t) (h->count * 0.99)) / 1e9,
+      h->max / 1e9);
+  }
+  printf("\n");
+}
+
+static void complete_interval(md_interval_t * r){
+  const int index = r->completed++;
+  interval_t * i = & r->intervals[index];
+  if(r->rank == 0){
+    print_interval(r, index, i);
+    md_hist_log2_counts(i->recv, r->heatmap + index * MD_HIST_LOG2_BUCKETS);
+    free(i->recv);
+  }
+  free(i->send);
+}
+
+void md_interval_progress(md_interval_t * r){
+  const double now = stop_timer(r->start_timer);
+  while(now >= r->start + r->interval){
+    end_interval(r, r->start + r->interval);
+  }
+  while(r->completed < r->count){
+    int flag;
+    MPI_Test(& r->intervals[r->completed].request, & flag, MPI_STATUS_IGNORE);
+    if(! flag){
+      break;
+    }
+    complete_interval(r);
+  }
+}
+
+static void write_heatmap(md_interval_t * r, const char * file){
+  FILE * f = fopen(file, "w+");
+  if(f == NULL){
+    printf("Error writing the heatmap file: %s\n", file);
+    return;
+  }
+  fprintf(f, "time");
+  for(int b=0; b < MD_HIST_LOG2_BUCKETS; b++){
+    fprintf(f, ",%.3e", (double) (1llu << b) / 1e9);
+  }
+  fprintf(f, "\n");
+  for(int i=0; i < r->count; i++){
+    fprintf(f, "%.3f", r->intervals[i].end);
+    for(int b=0; b < MD_HIST_LOG2_BUCKETS; b++){
+      fprintf(f, ",%llu", (long long unsigned) r->heatmap[i * MD_HIST_LOG2_BUCKETS + b]);
+    }
+    fprintf(f, "\n");
+  }
+  fclose(f);
+}
+
+void md_interval_finish(md_interval_t * r, const char * heatmap_file){
+  md_interval_progress(r);
+  end_interval(r, stop_timer(r->start_timer));
+  // processes may have ended a different number of intervals, the reductions must match
+  // the count is agreed on MPI_COMM_WORLD as the other processes may not have issued all reductions on comm
+  int count;
+  MPI_Allreduce(& r->count, & count, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  while(r->count < count){
+    end_interval(r, r->start + r->interval);
+  }
+  while(r->completed < r->count){
+    MPI_Wait(& r->intervals[r->completed].request, MPI_STATUS_IGNORE);
+    complete_interval(r);
+  }
+  if(r->rank == 0 && heatmap_file){
+    write_heatmap(r, heatmap_file);
+  }
+  free(r->current);
+  free(r->intervals);
+  free(r->heatmap);
+  free(r);
+}
@@ -0,0 +1,50 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_INTERVAL_H
+#define MD_INTERVAL_H
+
+#include <stdint.h>
+
+#include <mpi.h>
+
+/*
+ Periodic reporting of the operations completed within fixed time intervals of a phase.
+ Each process records the latencies of an interval into a histogram, at the end of the interval
+ the histograms are reduced to rank 0 with a non-blocking reduction that is progressed by later calls.
+ Thus, the operations are never blocked by slower processes, rank 0 prints each interval once all
+ processes have completed it.
+ The intervals are only ended within md_interval_progress(), i.e., when an operation completes. MPI is used by
+ the main thread only, so no other thread can end them: during a stalled operation nothing is printed, once it
+ completes, the intervals it spanned are ended at once and reported without operations.
+*/
+typedef struct md_interval md_interval_t;
+
+// comm is used exclusively for the interval reductions, type and op are created by md_hist_mpi_init()
+md_interval_t * md_interval_init(const char * name, double interval, int precision, MPI_Comm comm, MPI_Datatype type, MPI_Op op);
+
+// record the latency of an operation in ns
+void md_interval_add(md_interval_t * r, uint64_t value);
+
+// end the current interval if it is over and progress the reductions, the intervals start with md_interval_init()
+void md_interval_progress(md_interval_t * r);
+
+/* Complete all reductions and free the reporter, must be called by all processes at the same point.
+   If heatmap_file is not NULL, rank 0 writes the number of operations per interval and power of two latency range. */
+void md_interval_finish(md_interval_t * r, const char * heatmap_file);
+
+#endif
@@ -0,0 +1,206 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <md_util.h>
+#include <md_latency_writer.h>
+
+// the number of records per ring, must be a power of two
+#define RING_SIZE (1 << 16)
+// the files are written in blocks of this size, only the last block of a file is shorter
+#define BLOCK_SIZE (1024 * 1024)
+// the alignment of the block buffers, a page, thus the full blocks are aligned in memory and in the file
+#define BLOCK_ALIGN 4096
+#define CACHE_LINE 64
+
+typedef struct{
+  float time;
+  float runtime;
+  int file;
+} record_t;
+
+typedef struct{
+  uint64_t head; // written by the producer
+  char pad_head[CACHE_LINE - sizeof(uint64_t)];
+  uint64_t tail; // written by the writer thread
+  char pad_tail[CACHE_LINE - sizeof(uint64_t)];
+  // only accessed by the producer
+  uint64_t cached_tail;
+  double blocked;
+  record_t * records;
+  char pad[CACHE_LINE - 2 * sizeof(uint64_t) - sizeof(record_t *)];
+} ring_t;
+
+typedef struct{
+  char * name;
+  int fd;
+  char * buf;
+  size_t used;
+} out_file_t;
+
+struct md_lat_writer{
+  pthread_t thread;
+  int stop;
+  int producers;
+  ring_t * rings;
+  out_file_t files[MD_LAT_WRITER_FILES];
+};
+
+static void write_block(out_file_t * f, size_t size){
+  size_t pos = 0;
+  while(pos < size){
+    ssize_t ret = write(f->fd, f->buf + pos, size - pos);
+    if(ret <= 0){
+      printf("Error writing to latency file: %s\n", f->name);
+      return;
+    }
+    pos += ret;
+  }
+}
+
+static void format_record(md_lat_writer_t * w, record_t * r){
+  out_file_t * f = & w->files[r->file];
+  if(f->name == NULL){
+    return;
+  }
+  if(f->fd < 0){
+    f->fd = open(f->name, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if(f->fd < 0){
+      printf("Error writing to latency file: %s\n", f->name);
+      f->name = NULL;
+      return;
+    }
+    if(posix_memalign((void **) & f->buf, BLOCK_ALIGN, BLOCK_SIZE + 128) != 0){
+      printf("Error allocating the buffer of the latency file: %s\n", f->name);
+      close(f->fd);
+      f->fd = -1;
+      f->name = NULL;
+      return;
+    }
+    f->used = sprintf(f->buf, "time,runtime\n");
+  }
+  f->used += sprintf(f->buf + f->used, "%.7f,%.4e\n", r->time, r->runtime);
+  if(f->used >= BLOCK_SIZE){
+    write_block(f, BLOCK_SIZE);
+    f->used -= BLOCK_SIZE;
+    memmove(f->buf, f->buf + BLOCK_SIZE, f->used);
+  }
+}
+
+static void * writer_main(void * arg){
+  md_lat_writer_t * w = (md_lat_writer_t *) arg;
+  while(1){
+    // all records have been pushed before stop is set, so they are seen by the following pass
+    const int stop = __atomic_load_n(& w->stop, __ATOMIC_ACQUIRE);
+    uint64_t processed = 0;
+    for(int p=0; p < w->producers; p++){
+      ring_t * r = & w->rings[p];
+      const uint64_t head = __atomic_load_n(& r->head, __ATOMIC_ACQUIRE);
+      for(uint64_t t = r->tail; t < head; t++){
+        format_record(w, & r->records[t & (RING_SIZE - 1)]);
+      }
+      processed += head - r->tail;
+      __atomic_store_n(& r->tail, head, __ATOMIC_RELEASE);
+    }
+    if(processed == 0){
+      if(stop){
+        break;
+      }
+      struct timespec wait = {0, 100 * 1000};
+      nanosleep(& wait, NULL);
+    }
+  }
+  for(int i=0; i < MD_LAT_WRITER_FILES; i++){
+    out_file_t * f = & w->files[i];
+    if(f->fd >= 0){
+      write_block(f, f->used);
+      close(f->fd);
+      free(f->buf);
+    }
+  }
+  return NULL;
+}
+
+md_lat_writer_t * md_lat_writer_start(char * files[MD_LAT_WRITER_FILES], int producers){
+  md_lat_writer_t * w = malloc(sizeof(md_lat_writer_t));
+  memset(w, 0, sizeof(md_lat_writer_t));
+  w->producers = producers;
+  if(posix_memalign((void **) & w->rings, CACHE_LINE, sizeof(ring_t) * producers) != 0){
+    printf("Error allocating the latency writer\n");
+    exit(1);
+  }
+  memset(w->rings, 0, sizeof(ring_t) * producers);
+  for(int p=0; p < producers; p++){
+    w->rings[p].records = malloc(sizeof(record_t) * RING_SIZE);
+  }
+  for(int i=0; i < MD_LAT_WRITER_FILES; i++){
+    w->files[i].name = files[i] ? strdup(files[i]) : NULL;
+    w->files[i].fd = -1;
+  }
+  pthread_create(& w->thread, NULL, writer_main, w);
+  return w;
+}
+
+void md_lat_writer_push(md_lat_writer_t * w, int producer, int file, float time, float runtime){
+  ring_t * r = & w->rings[producer];
+  if(r->head - r->cached_tail == RING_SIZE){
+    r->cached_tail = __atomic_load_n(& r->tail, __ATOMIC_ACQUIRE);
+    if(r->head - r->cached_tail == RING_SIZE){
+      // back-pressure: wait until the writer has consumed records
+      timer start;
+      start_timer(& start);
+      while(r->head - r->cached_tail == RING_SIZE){
+        sched_yield();
+        r->cached_tail = __atomic_load_n(& r->tail, __ATOMIC_ACQUIRE);
+      }
+      r->blocked += stop_timer(start);
+    }
+  }
+  record_t * rec = & r->records[r->head & (RING_SIZE - 1)];
+  rec->time = time;
+  rec->runtime = runtime;
+  rec->file = file;
+  __atomic_store_n(& r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+double md_lat_writer_stop(md_lat_writer_t * w){
+  __atomic_store_n(& w->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(w->thread, NULL);
+  double blocked = 0;
+  for(int p=0; p < w->producers; p++){
+    blocked += w->rings[p].blocked;
+    free(w->rings[p].records);
+  }
+  for(int i=0; i < MD_LAT_WRITER_FILES; i++){
+    free(w->files[i].name);
+  }
+  free(w->rings);
+  free(w);
+  return blocked;
+}
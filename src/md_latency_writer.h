@@ -0,0 +1,40 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_LATENCY_WRITER_H
+#define MD_LATENCY_WRITER_H
+
+/*
+ Streams the latency records of a phase into CSV files using a background thread.
+ Each producer thread owns a lock-free single-producer/single-consumer ring, the writer thread
+ formats the records and writes them in large page-aligned blocks. If a ring is full, the producer waits
+ for the writer, no record is dropped.
+*/
+typedef struct md_lat_writer md_lat_writer_t;
+
+#define MD_LAT_WRITER_FILES 4
+
+// start the writer thread, a file is created once the first record for it is pushed, file names may be NULL
+md_lat_writer_t * md_lat_writer_start(char * files[MD_LAT_WRITER_FILES], int producers);
+
+// append a record to the ring of the producer, file is the index into the files
+void md_lat_writer_push(md_lat_writer_t * w, int producer, int file, float time, float runtime);
+
+// write all remaining records, stop the thread and return the total time in seconds the producers waited for the writer
+double md_lat_writer_stop(md_lat_writer_t * w);
+
+#endif
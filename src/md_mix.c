@@ -0,0 +1,209 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <md_util.h>
+#include <md_mix.h>
+
+static const char * type_names[] = {"create", "read", "stat", "delete"};
+static const char * select_names[] = {"uniform", "sequential"};
+
+static uint64_t hash(uint64_t seed, int64_t iteration, int dset, uint64_t item){
+  return mix64(mix64(mix64(seed ^ (uint64_t) iteration) ^ (uint64_t) dset) ^ item);
+}
+
+static int parse_item(md_mix_t * m, char * item, char * err){
+  char * value = strchr(item, '=');
+  if(value == NULL){
+    sprintf(err, "expected key=value: %.100s", item);
+    return 1;
+  }
+  *value = 0;
+  value++;
+  char * end;
+  if(strcmp(item, "ops") == 0){
+    m->ops = (int) strtol(value, & end, 10);
+    if(*end != 0 || m->ops < 1){
+      sprintf(err, "invalid number of operations: %.100s", value);
+      return 1;
+    }
+    return 0;
+  }
+  if(strcmp(item, "seed") == 0){
+    m->seed = strtoull(value, & end, 10);
+    if(*end != 0){
+      sprintf(err, "invalid seed: %.100s", value);
+      return 1;
+    }
+    return 0;
+  }
+  if(strcmp(item, "order") == 0){
+    if(strcmp(value, "shuffle") != 0 && strcmp(value, "grouped") != 0){
+      sprintf(err, "the order must be shuffle or grouped: %.100s", value);
+      return 1;
+    }
+    m->grouped = value[0] == 'g';
+    return 0;
+  }
+  for(int t=0; t < 4; t++){
+    if(strcmp(item, type_names[t]) != 0){
+      continue;
+    }
+    char * policy = strchr(value, ':');
+    if(policy){
+      *policy = 0;
+      policy++;
+      if(t != MD_OP_STAT && t != MD_OP_READ){
+        sprintf(err, "the objects of %.100s cannot be selected", item);
+        return 1;
+      }
+      if(strcmp(policy, select_names[MD_MIX_UNIFORM]) == 0){
+        m->select[t] = MD_MIX_UNIFORM;
+      }else if(strcmp(policy, select_names[MD_MIX_SEQUENTIAL]) == 0){
+        m->select[t] = MD_MIX_SEQUENTIAL;
+      }else{
+        sprintf(err, "the selection must be uniform or sequential: %.100s", policy);
+        return 1;
+      }
+    }
+    m->weight[t] = strtod(value, & end);
+    if(*end != 0 || m->weight[t] < 0){
+      sprintf(err, "invalid weight for %s: %.100s", item, value);
+      return 1;
+    }
+    return 0;
+  }
+  sprintf(err, "unknown key: %.100s", item);
+  return 1;
+}
+
+int md_mix_parse(md_mix_t * m, const char * spec, char * err){
+  memset(m, 0, sizeof(md_mix_t));
+  m->ops = 100;
+  char * buff = strdup(spec);
+  int ret = 0;
+  // strip the comments
+  for(char * p = buff; *p; p++){
+    if(*p == '#'){
+      while(*p && *p != '\n'){
+        *p = ' ';
+        p++;
+      }
+      if(! *p){
+        break;
+      }
+    }
+  }
+  char * save;
+  for(char * item = strtok_r(buff, ", \t\r\n", & save); item && ! ret; item = strtok_r(NULL, ", \t\r\n", & save)){
+    ret = parse_item(m, item, err);
+  }
+  free(buff);
+  if(ret){
+    return ret;
+  }
+
+  // distribute the operations of an iteration by the largest remainder
+  double total = 0;
+  for(int t=0; t < 4; t++){
+    total += m->weight[t];
+  }
+  if(total <= 0){
+    sprintf(err, "no operation has a weight");
+    return 1;
+  }
+  double remainder[4];
+  int assigned = 0;
+  for(int t=0; t < 4; t++){
+    const double share = m->ops * m->weight[t] / total;
+    m->count[t] = (int) share;
+    remainder[t] = share - m->count[t];
+    assigned += m->count[t];
+  }
+  for(; assigned < m->ops; assigned++){
+    int max = 0;
+    for(int t=1; t < 4; t++){
+      if(remainder[t] > remainder[max]){
+        max = t;
+      }
+    }
+    m->count[max]++;
+    remainder[max] = -1;
+  }
+  return 0;
+}
+
+int md_mix_load(md_mix_t * m, const char * file, char * err){
+  FILE * f = fopen(file, "r");
+  if(f == NULL){
+    sprintf(err, "cannot open the file %.100s", file);
+    return 1;
+  }
+  char buff[4096];
+  size_t len = fread(buff, 1, sizeof(buff) - 1, f);
+  const int truncated = ! feof(f);
+  fclose(f);
+  if(truncated){
+    sprintf(err, "the file %.100s is too large", file);
+    return 1;
+  }
+  buff[len] = 0;
+  return md_mix_parse(m, buff, err);
+}
+
+void md_mix_iteration(md_mix_t * m, int64_t iteration, int dset, uint8_t * types){
+  // in the order stat, read, create, delete
+  const md_op_type order[] = {MD_OP_STAT, MD_OP_READ, MD_OP_WRITE, MD_OP_DELETE};
+  int pos = 0;
+  for(int i=0; i < 4; i++){
+    for(int c=0; c < m->count[order[i]]; c++){
+      types[pos++] = (uint8_t) order[i];
+    }
+  }
+  if(m->grouped){
+    return;
+  }
+  // Fisher-Yates
+  for(int i = m->ops - 1; i > 0; i--){
+    const int j = (int) (hash(m->seed, iteration, dset, i) % (uint64_t) (i + 1));
+    const uint8_t tmp = types[i];
+    types[i] = types[j];
+    types[j] = tmp;
+  }
+}
+
+uint64_t md_mix_select_obj(md_mix_t * m, md_op_type type, int64_t iteration, int dset, int j, uint64_t count){
+  if(m->select[type] == MD_MIX_SEQUENTIAL){
+    return ((uint64_t) iteration * m->count[type] + j) % count;
+  }
+  return hash(m->seed + 1 + type, iteration, dset, j) % count;
+}
+
+void md_mix_print(md_mix_t * m, char * buff){
+  int pos = sprintf(buff, "ops:%d order:%s", m->ops, m->grouped ? "grouped" : "shuffle");
+  const md_op_type order[] = {MD_OP_STAT, MD_OP_READ, MD_OP_WRITE, MD_OP_DELETE};
+  for(int i=0; i < 4; i++){
+    const md_op_type t = order[i];
+    pos += sprintf(buff + pos, " %s:%d", type_names[t], m->count[t]);
+    if(t == MD_OP_STAT || t == MD_OP_READ){
+      pos += sprintf(buff + pos, "(%s)", select_names[m->select[t]]);
+    }
+  }
+}
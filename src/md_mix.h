@@ -0,0 +1,64 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_MIX_H
+#define MD_MIX_H
+
+#include <stdint.h>
+
+#include <plugins/md-plugin.h>
+
+/*
+ A declarative mix of the operations of the benchmark phase, e.g., "stat=70,read=20:sequential,create=7,delete=3".
+ The items are separated by commas, spaces or newlines, # starts a comment:
+   stat=W[:P], read=W[:P], create=W, delete=W  the weight of the operation type and how the object is selected:
+                                               uniform (random) or sequential, default uniform
+   ops=N                                       the operations per dataset that form one iteration, default 100
+   order=shuffle|grouped                       interleave the operations of an iteration or issue them in bursts of one type
+   seed=N                                      the seed for the shuffle and the uniform selection
+ The weights are converted into a fixed number of operations of each type per iteration. All decisions
+ depend only on the seed, the iteration and the dataset, thus, the sequence is reproducible on all processes.
+*/
+typedef enum{
+  MD_MIX_UNIFORM,
+  MD_MIX_SEQUENTIAL
+} md_mix_select;
+
+typedef struct{
+  int ops;
+  int count[4]; // indexed by md_op_type
+  double weight[4];
+  md_mix_select select[4];
+  int grouped;
+  uint64_t seed;
+} md_mix_t;
+
+// returns 0 on success, otherwise err contains the reason
+int md_mix_parse(md_mix_t * m, const char * spec, char * err);
+// parse the spec stored in the file
+int md_mix_load(md_mix_t * m, const char * file, char * err);
+
+// the types of the operations of the iteration for the dataset, types must hold m->ops entries
+void md_mix_iteration(md_mix_t * m, int64_t iteration, int dset, uint8_t * types);
+
+// the object out of count objects accessed by the j-th operation of the type within the iteration
+uint64_t md_mix_select_obj(md_mix_t * m, md_op_type type, int64_t iteration, int dset, int j, uint64_t count);
+
+// a description of the mix, e.g., for the header
+void md_mix_print(md_mix_t * m, char * buff);
+
+#endif
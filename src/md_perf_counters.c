@@ -0,0 +1,111 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <md_perf_counters.h>
+
+const char * md_perf_counter_names[MD_PC_COUNT] = {"cycles", "instructions", "ctx-switches", "page-faults", "cpu-migrations"};
+
+static const uint32_t types[MD_PC_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE};
+static const uint64_t configs[MD_PC_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_SW_CONTEXT_SWITCHES, PERF_COUNT_SW_PAGE_FAULTS, PERF_COUNT_SW_CPU_MIGRATIONS};
+
+static int open_counter(int i, int user_only){
+  struct perf_event_attr attr;
+  memset(& attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = types[i];
+  attr.config = configs[i];
+  attr.inherit = 1; // include the worker threads once they are joined
+  attr.exclude_kernel = user_only;
+  attr.exclude_hv = user_only;
+  // the times tell whether the counter was multiplexed with others, i.e., counted only part of the time
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int) syscall(SYS_perf_event_open, & attr, 0, -1, -1, 0);
+}
+
+static int open_all(md_perf_counters_t * pc, int user_only){
+  int available = 0;
+  memset(pc, 0, sizeof(md_perf_counters_t));
+  pc->user_only = user_only;
+  for(int i=0; i < MD_PC_COUNT; i++){
+    pc->fd[i] = open_counter(i, user_only);
+    if(pc->fd[i] >= 0){
+      available |= 1 << i;
+    }
+  }
+  return available;
+}
+
+int md_perf_open(md_perf_counters_t * pc){
+  int available = open_all(pc, 0);
+  if(available != (1 << MD_PC_COUNT) - 1){
+    // counting the kernel needs perf_event_paranoid <= 1, use the mode with the most counters
+    md_perf_counters_t user;
+    const int available_user = open_all(& user, 1);
+    if(__builtin_popcount(available_user) > __builtin_popcount(available)){
+      md_perf_close(pc);
+      *pc = user;
+      available = available_user;
+    }else{
+      md_perf_close(& user);
+    }
+  }
+  return available;
+}
+
+void md_perf_read(md_perf_counters_t * pc, uint64_t values[MD_PC_COUNT]){
+  for(int i=0; i < MD_PC_COUNT; i++){
+    // the value, the time enabled and the time running
+    uint64_t buf[3];
+    values[i] = 0;
+    if(pc->fd[i] < 0 || read(pc->fd[i], buf, sizeof(buf)) != sizeof(buf)){
+      continue;
+    }
+    pc->enabled[i] = buf[1];
+    pc->running[i] = buf[2];
+    if(buf[2] == 0){
+      // never scheduled, nothing is known about the value
+      continue;
+    }
+    values[i] = buf[2] < buf[1] ? (uint64_t) ((double) buf[0] * buf[1] / buf[2]) : buf[0];
+  }
+}
+
+int md_perf_multiplexed(md_perf_counters_t * pc){
+  int multiplexed = 0;
+  for(int i=0; i < MD_PC_COUNT; i++){
+    if(pc->running[i] - pc->mark_running[i] < pc->enabled[i] - pc->mark_enabled[i]){
+      multiplexed |= 1 << i;
+    }
+    pc->mark_enabled[i] = pc->enabled[i];
+    pc->mark_running[i] = pc->running[i];
+  }
+  return multiplexed;
+}
+
+void md_perf_close(md_perf_counters_t * pc){
+  for(int i=0; i < MD_PC_COUNT; i++){
+    if(pc->fd[i] >= 0){
+      close(pc->fd[i]);
+      pc->fd[i] = -1;
+    }
+  }
+}
@@ -0,0 +1,62 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_PERF_COUNTERS_H
+#define MD_PERF_COUNTERS_H
+
+#include <stdint.h>
+
+/*
+ Hardware and software counters of the calling thread and the threads it creates afterwards,
+ read with perf_event_open(2). Counters that cannot be opened, e.g., in containers or virtual
+ machines without a PMU, are marked unavailable and read as 0, the remaining counters still work.
+ If there are more counters than the PMU provides, the kernel multiplexes them and each counts only
+ part of the time; the values are then scaled by the time enabled / the time running, i.e., estimated.
+*/
+typedef enum{
+  MD_PC_CYCLES,
+  MD_PC_INSTRUCTIONS,
+  MD_PC_CONTEXT_SWITCHES,
+  MD_PC_PAGE_FAULTS,
+  MD_PC_CPU_MIGRATIONS,
+  MD_PC_COUNT
+} md_perf_counter;
+
+extern const char * md_perf_counter_names[MD_PC_COUNT];
+
+typedef struct{
+  int fd[MD_PC_COUNT];
+  int user_only; // the kernel is excluded as the permissions do not allow to count it
+  // the times of the last read and of the last md_perf_multiplexed() in ns
+  uint64_t enabled[MD_PC_COUNT];
+  uint64_t running[MD_PC_COUNT];
+  uint64_t mark_enabled[MD_PC_COUNT];
+  uint64_t mark_running[MD_PC_COUNT];
+} md_perf_counters_t;
+
+// open the counters, returns a bitmask of the available counters
+int md_perf_open(md_perf_counters_t * pc);
+
+// the current values since md_perf_open(), scaled if the counters are multiplexed
+void md_perf_read(md_perf_counters_t * pc, uint64_t values[MD_PC_COUNT]);
+
+// a bitmask of the counters that were multiplexed between the last reads before this and the previous call
+int md_perf_multiplexed(md_perf_counters_t * pc);
+
+void md_perf_close(md_perf_counters_t * pc);
+
+#endif
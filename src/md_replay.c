@@ -0,0 +1,277 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <md_replay.h>
+
+// the processed part of the trace is released in windows of this size
+#define RELEASE_WINDOW (64 * 1024 * 1024)
+#define MAX_LINE 4096
+#define SEPARATORS " \t\r"
+
+// open addressing with linear probing, the capacity is a power of two
+// the paths are stored as well, thus paths with the same hash are distinct entries
+typedef struct{
+  md_replay_entry_t * slots;
+  size_t capacity;
+  size_t count;
+  char * paths; // the paths of the entries without terminator
+  size_t paths_used;
+  size_t paths_capacity;
+} table_t;
+
+struct md_replay{
+  char * data;
+  size_t size;
+  size_t pos;
+  size_t released; // the pages before this position have been released
+  size_t line;
+  table_t tables[2]; // the data sets and the objects
+};
+
+static const char * op_names[] = {"create", "read", "stat", "delete", "mkdir", "rmdir"};
+
+static uint64_t hash_path(const char * path, size_t len){
+  // FNV-1a
+  uint64_t h = 0xcbf29ce484222325ull;
+  for(size_t i=0; i < len; i++){
+    h = (h ^ (uint8_t) path[i]) * 0x100000001b3ull;
+  }
+  return h == 0 ? 1 : h;
+}
+
+static void table_init(table_t * t){
+  t->capacity = 1024;
+  t->count = 0;
+  t->slots = calloc(t->capacity, sizeof(md_replay_entry_t));
+  t->paths_capacity = 64 * 1024;
+  t->paths_used = 0;
+  t->paths = malloc(t->paths_capacity);
+}
+
+// the slot of the path or the empty slot for it, without a path the first empty slot for the key
+static md_replay_entry_t * table_find(table_t * t, md_replay_entry_t * slots, size_t capacity, uint64_t key, const char * path, size_t len){
+  size_t i = key & (capacity - 1);
+  while(slots[i].key != 0){
+    if(path && slots[i].key == key && slots[i].path_len == len && memcmp(t->paths + slots[i].path, path, len) == 0){
+      break;
+    }
+    i = (i + 1) & (capacity - 1);
+  }
+  return & slots[i];
+}
+
+// the entry of the path, a new entry gets the next number
+static md_replay_entry_t * table_get(table_t * t, const char * path, size_t len){
+  const uint64_t key = hash_path(path, len);
+  md_replay_entry_t * e = table_find(t, t->slots, t->capacity, key, path, len);
+  if(e->key != 0){
+    return e;
+  }
+  if(2 * (t->count + 1) > t->capacity){
+    md_replay_entry_t * slots = calloc(2 * t->capacity, sizeof(md_replay_entry_t));
+    for(size_t i=0; i < t->capacity; i++){
+      if(t->slots[i].key != 0){
+        *table_find(t, slots, 2 * t->capacity, t->slots[i].key, NULL, 0) = t->slots[i];
+      }
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->capacity *= 2;
+    e = table_find(t, t->slots, t->capacity, key, NULL, 0);
+  }
+  if(t->paths_used + len > t->paths_capacity){
+    while(t->paths_used + len > t->paths_capacity){
+      t->paths_capacity *= 2;
+    }
+    t->paths = realloc(t->paths, t->paths_capacity);
+  }
+  memcpy(t->paths + t->paths_used, path, len);
+  e->path = t->paths_used;
+  e->path_len = (uint32_t) len;
+  t->paths_used += len;
+  e->key = key;
+  e->id = (int32_t) t->count++;
+  return e;
+}
+
+md_replay_t * md_replay_open(const char * file, char * err){
+  int fd = open(file, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, & st) != 0){
+    sprintf(err, "cannot open the file %.100s", file);
+    if(fd >= 0){
+      close(fd);
+    }
+    return NULL;
+  }
+  md_replay_t * r = malloc(sizeof(md_replay_t));
+  memset(r, 0, sizeof(md_replay_t));
+  r->size = st.st_size;
+  if(r->size > 0){
+    r->data = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(r->data == MAP_FAILED){
+      sprintf(err, "cannot map the file %.100s", file);
+      close(fd);
+      free(r);
+      return NULL;
+    }
+    madvise(r->data, r->size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  table_init(& r->tables[0]);
+  table_init(& r->tables[1]);
+  return r;
+}
+
+// the pages before the current position are not accessed again until the trace is rewound
+static void release(md_replay_t * r){
+  if(r->pos - r->released < RELEASE_WINDOW){
+    return;
+  }
+  const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  const size_t end = r->pos / page * page;
+  madvise(r->data + r->released, end - r->released, MADV_DONTNEED);
+  r->released = end;
+}
+
+static int parse_op(md_replay_t * r, md_replay_op_t * op, char * word, char ** save, char * err){
+  int type = -1;
+  for(int i=0; i < 6; i++){
+    if(strcmp(word, op_names[i]) == 0){
+      type = i;
+    }
+  }
+  if(strcmp(word, "write") == 0){
+    type = MD_OP_WRITE;
+  }else if(strcmp(word, "rm") == 0){
+    type = MD_OP_DELETE;
+  }
+  char * path = strtok_r(NULL, SEPARATORS, save);
+  // the pattern of the dummy plugin qualifies the operation
+  if(path && strcmp(path, "dset:") == 0 && (type == MD_OP_WRITE || type == MD_OP_DELETE)){
+    type = type == MD_OP_WRITE ? MD_REPLAY_MKDIR : MD_REPLAY_RMDIR;
+    path = strtok_r(NULL, SEPARATORS, save);
+  }else if(path && strcmp(path, "obj:") == 0 && type >= 0 && type < MD_REPLAY_MKDIR){
+    path = strtok_r(NULL, SEPARATORS, save);
+  }
+  if(type < 0 || path == NULL){
+    sprintf(err, "line %zu: expected <op> <path> with op create, read, stat, delete, mkdir or rmdir: %.100s", r->line, word);
+    return -1;
+  }
+
+  op->type = type;
+  op->size = -1;
+  op->delay = 0;
+  char * value = strtok_r(NULL, SEPARATORS, save);
+  char * end;
+  if(value){
+    long long size = strtoll(value, & end, 10);
+    if(*end != 0 || size < 0 || size > UINT32_MAX){
+      sprintf(err, "line %zu: invalid size: %.100s", r->line, value);
+      return -1;
+    }
+    op->size = size;
+    value = strtok_r(NULL, SEPARATORS, save);
+  }
+  if(value){
+    op->delay = strtod(value, & end);
+    if(*end != 0 || op->delay < 0){
+      sprintf(err, "line %zu: invalid inter-arrival time: %.100s", r->line, value);
+      return -1;
+    }
+    value = strtok_r(NULL, SEPARATORS, save);
+  }
+  if(value){
+    sprintf(err, "line %zu: unexpected value: %.100s", r->line, value);
+    return -1;
+  }
+
+  size_t len = strlen(path);
+  if(type >= MD_REPLAY_MKDIR){
+    while(len > 1 && path[len - 1] == '/'){
+      len--;
+    }
+    op->dset = table_get(& r->tables[0], path, len);
+    op->obj = NULL;
+    return 1;
+  }
+  const char * slash = strrchr(path, '/');
+  op->dset = table_get(& r->tables[0], path, slash ? (size_t) (slash - path) : 0);
+  op->obj = table_get(& r->tables[1], path, len);
+  op->obj->dset = op->dset->id;
+  return 1;
+}
+
+int md_replay_next(md_replay_t * r, md_replay_op_t * op, char * err){
+  char line[MAX_LINE];
+  while(r->pos < r->size){
+    const char * start = r->data + r->pos;
+    const char * end = memchr(start, '\n', r->size - r->pos);
+    const size_t len = end ? (size_t) (end - start) : r->size - r->pos;
+    r->line++;
+    if(len >= MAX_LINE){
+      sprintf(err, "line %zu is too long", r->line);
+      return -1;
+    }
+    memcpy(line, start, len);
+    line[len] = 0;
+    r->pos += len + (end ? 1 : 0);
+    release(r);
+
+    char * save;
+    char * word = strtok_r(line, SEPARATORS, & save);
+    if(word == NULL || word[0] == '#'){
+      continue;
+    }
+    return parse_op(r, op, word, & save, err);
+  }
+  return 0;
+}
+
+void md_replay_rewind(md_replay_t * r){
+  r->pos = 0;
+  r->released = 0;
+  r->line = 0;
+}
+
+md_replay_entry_t * md_replay_entries(md_replay_t * r, int objects, size_t * slots){
+  *slots = r->tables[objects ? 1 : 0].capacity;
+  return r->tables[objects ? 1 : 0].slots;
+}
+
+size_t md_replay_count(md_replay_t * r, int objects){
+  return r->tables[objects ? 1 : 0].count;
+}
+
+void md_replay_close(md_replay_t * r){
+  if(r->data){
+    munmap(r->data, r->size);
+  }
+  for(int i=0; i < 2; i++){
+    free(r->tables[i].slots);
+    free(r->tables[i].paths);
+  }
+  free(r);
+}
@@ -0,0 +1,79 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+#ifndef MD_REPLAY_H
+#define MD_REPLAY_H
+
+#include <stdint.h>
+
+#include <plugins/md-plugin.h>
+
+/*
+ Replays a recorded trace of a process, one operation per line:
+   <op> <path> [<size>] [<inter-arrival time>]
+ op is create (or write), read, stat, delete, mkdir or rmdir, the size is in bytes and the inter-arrival time is
+ the time in seconds since the start of the previous operation. Empty lines and lines starting with # are skipped.
+ The size of a create is the new size of the object, other operations use the current size of the object,
+ their size is only used for the objects that exist before the trace, by default the size is -S.
+ The pattern written by the dummy plugin with --print-pattern, e.g., "write obj: n=0/d=1/i=5", is accepted as well.
+ The directory of the path of an object is its data set, each distinct directory and path is mapped to a dense
+ number in the order of its first use, i.e., the data set and object number used for the names of the plugin.
+ The file is memory-mapped and processed sequentially, the pages already processed are released again.
+*/
+typedef struct md_replay md_replay_t;
+
+// the data set operations in addition to md_op_type
+#define MD_REPLAY_MKDIR 4
+#define MD_REPLAY_RMDIR 5
+
+// a data set or an object of the trace
+typedef struct{
+  uint64_t key; // the hash of the path, 0 marks an empty slot
+  int32_t id; // the number in the order of the first use
+  int32_t dset; // the data set of an object
+  uint32_t size; // the size of an object, maintained by the caller
+  uint8_t state; // maintained by the caller, 0 for a path that has not been used before
+  uint32_t path_len; // the path, stored by md_replay to tell paths with the same hash apart
+  uint64_t path;
+} md_replay_entry_t;
+
+typedef struct{
+  int type; // md_op_type or MD_REPLAY_MKDIR/RMDIR
+  int64_t size; // -1 if the trace contains no size
+  double delay; // the inter-arrival time in seconds
+  md_replay_entry_t * dset; // for MKDIR/RMDIR the path itself
+  md_replay_entry_t * obj; // NULL for MKDIR/RMDIR
+} md_replay_op_t;
+
+// map the trace file, returns NULL and the reason in err on error
+md_replay_t * md_replay_open(const char * file, char * err);
+
+// the next operation, returns 1 on success, 0 at the end of the trace and -1 with the reason in err on a malformed line
+// the entries are valid until the next call
+int md_replay_next(md_replay_t * r, md_replay_op_t * op, char * err);
+
+// continue with the first operation, the entries are kept
+void md_replay_rewind(md_replay_t * r);
+
+// the table of the data sets or objects, the slots with a key of 0 are empty
+md_replay_entry_t * md_replay_entries(md_replay_t * r, int objects, size_t * slots);
+
+// the number of distinct data sets or objects
+size_t md_replay_count(md_replay_t * r, int objects);
+
+void md_replay_close(md_replay_t * r);
+
+#endif
@@ -0,0 +1,197 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <md_util.h>
+#include <md_size_dist.h>
+
+// the objects sampled for the mean size
+#define MEAN_SAMPLES 10000
+
+// a uniform number in (0, 1) for the object
+static double uniform(int rank, int dset, int64_t obj, uint64_t stream){
+  const uint64_t h = mix64(mix64(mix64(mix64(stream) ^ (uint64_t) rank) ^ (uint64_t) dset) ^ (uint64_t) obj);
+  return ((h >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int parse_size(const char * str, size_t * out){
+  char * end;
+  const long long val = strtoll(str, & end, 10);
+  if(end == str || *end != 0 || val < 0){
+    return 1;
+  }
+  *out = (size_t) val;
+  return 0;
+}
+
+static int load_histogram(md_size_dist_t * d, const char * file, char * err){
+  FILE * f = fopen(file, "r");
+  if(f == NULL){
+    sprintf(err, "cannot open the file %.100s", file);
+    return 1;
+  }
+  char line[1024];
+  int capacity = 0;
+  double total = 0;
+  while(fgets(line, sizeof(line), f)){
+    char * comment = strchr(line, '#');
+    if(comment){
+      *comment = 0;
+    }
+    long long bound;
+    double weight;
+    const int items = sscanf(line, "%lld %lf", & bound, & weight);
+    if(items <= 0){
+      continue;
+    }
+    if(items != 2 || bound < 0 || weight < 0 || (d->buckets > 0 && (size_t) bound <= d->bound[d->buckets - 1])){
+      sprintf(err, "invalid bucket in %.100s, expected increasing bounds and weights: %.100s", file, line);
+      fclose(f);
+      return 1;
+    }
+    if(d->buckets == capacity){
+      capacity = capacity == 0 ? 16 : capacity * 2;
+      d->bound = realloc(d->bound, sizeof(size_t) * capacity);
+      d->cdf = realloc(d->cdf, sizeof(double) * capacity);
+    }
+    total += weight;
+    d->bound[d->buckets] = (size_t) bound;
+    d->cdf[d->buckets] = total;
+    d->buckets++;
+  }
+  fclose(f);
+  if(total <= 0){
+    sprintf(err, "the histogram %.100s has no weight", file);
+    return 1;
+  }
+  for(int i=0; i < d->buckets; i++){
+    d->cdf[i] /= total;
+  }
+  d->max = d->bound[d->buckets - 1];
+  return 0;
+}
+
+int md_size_dist_parse(md_size_dist_t * d, const char * spec, size_t fixed, char * err){
+  memset(d, 0, sizeof(md_size_dist_t));
+  d->min = fixed;
+  d->max = fixed;
+  char * buff = strdup(spec);
+  char * args[4] = {NULL, NULL, NULL, NULL};
+  int count = 0;
+  char * save;
+  for(char * tok = strtok_r(buff, ":", & save); tok && count < 4; tok = strtok_r(NULL, ":", & save)){
+    args[count++] = tok;
+  }
+  int ret = 0;
+  if(count == 0 || strcmp(args[0], "fixed") == 0){
+    d->type = MD_SIZE_FIXED;
+    ret = count > 1;
+  }else if(strcmp(args[0], "uniform") == 0){
+    d->type = MD_SIZE_UNIFORM;
+    ret = count != 3 || parse_size(args[1], & d->min) || parse_size(args[2], & d->max) || d->min > d->max;
+  }else if(strcmp(args[0], "lognormal") == 0){
+    d->type = MD_SIZE_LOGNORMAL;
+    char * end;
+    ret = count != 4 || parse_size(args[3], & d->max);
+    if(! ret){
+      d->median = strtod(args[1], & end);
+      ret = *end != 0 || d->median <= 0;
+      d->sigma = strtod(args[2], & end);
+      ret |= *end != 0 || d->sigma < 0;
+    }
+    d->min = 0;
+  }else if(strcmp(args[0], "empirical") == 0 && count >= 2){
+    d->type = MD_SIZE_EMPIRICAL;
+    // the file name may contain colons
+    ret = load_histogram(d, spec + strlen("empirical:"), err);
+    free(buff);
+    return ret;
+  }else{
+    ret = 1;
+  }
+  if(ret){
+    sprintf(err, "expected fixed, uniform:MIN:MAX, lognormal:MEDIAN:SIGMA:MAX or empirical:FILE: %.100s", spec);
+  }
+  free(buff);
+  return ret;
+}
+
+void md_size_dist_free(md_size_dist_t * d){
+  free(d->bound);
+  free(d->cdf);
+}
+
+size_t md_size_dist_get(md_size_dist_t * d, int rank, int dset, int64_t obj){
+  switch(d->type){
+    case(MD_SIZE_FIXED):
+      return d->max;
+    case(MD_SIZE_UNIFORM):
+      return d->min + (size_t) (uniform(rank, dset, obj, 0) * (d->max - d->min + 1));
+    case(MD_SIZE_LOGNORMAL):{
+      // Box-Muller
+      const double z = sqrt(-2 * log(uniform(rank, dset, obj, 0))) * cos(2 * M_PI * uniform(rank, dset, obj, 1));
+      const double size = d->median * exp(d->sigma * z);
+      return size >= d->max ? d->max : (size_t) size;
+    }case(MD_SIZE_EMPIRICAL):{
+      const double u = uniform(rank, dset, obj, 0);
+      int b = 0;
+      while(b < d->buckets - 1 && d->cdf[b] < u){
+        b++;
+      }
+      const size_t low = b == 0 ? 0 : d->bound[b - 1] + 1;
+      return low + (size_t) (uniform(rank, dset, obj, 1) * (d->bound[b] - low + 1));
+    }
+  }
+  return d->max;
+}
+
+size_t md_size_dist_max(md_size_dist_t * d){
+  return d->max;
+}
+
+double md_size_dist_mean(md_size_dist_t * d){
+  if(d->type == MD_SIZE_FIXED){
+    return d->max;
+  }
+  double sum = 0;
+  for(int i=0; i < MEAN_SAMPLES; i++){
+    sum += md_size_dist_get(d, 0, 0, i);
+  }
+  return sum / MEAN_SAMPLES;
+}
+
+void md_size_dist_print(md_size_dist_t * d, char * buff){
+  switch(d->type){
+    case(MD_SIZE_FIXED):
+      sprintf(buff, "fixed %zu", d->max);
+      break;
+    case(MD_SIZE_UNIFORM):
+      sprintf(buff, "uniform %zu-%zu", d->min, d->max);
+      break;
+    case(MD_SIZE_LOGNORMAL):
+      sprintf(buff, "lognormal median:%.0f sigma:%.2f max:%zu", d->median, d->sigma, d->max);
+      break;
+    case(MD_SIZE_EMPIRICAL):
+      sprintf(buff, "empirical %d buckets max:%zu", d->buckets, d->max);
+      break;
+  }
+  sprintf(buff + strlen(buff), " mean:%.0f", md_size_dist_mean(d));
+}
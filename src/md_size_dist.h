@@ -0,0 +1,64 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_SIZE_DIST_H
+#define MD_SIZE_DIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ The distribution of the object sizes, the size of an object is drawn deterministically from the owning rank,
+ the dataset and the index of the object. Thus, every process derives the same size for an object.
+   fixed                       all objects have the size of -S
+   uniform:MIN:MAX             uniform between MIN and MAX bytes
+   lognormal:MEDIAN:SIGMA:MAX  log-normal with the median in bytes and the standard deviation of the logarithm, limited to MAX
+   empirical:FILE              a histogram, each line of the file contains the upper bound of a bucket in bytes
+                               and its weight, the sizes are uniform within a bucket; # starts a comment
+*/
+typedef enum{
+  MD_SIZE_FIXED,
+  MD_SIZE_UNIFORM,
+  MD_SIZE_LOGNORMAL,
+  MD_SIZE_EMPIRICAL
+} md_size_dist_type;
+
+typedef struct{
+  md_size_dist_type type;
+  size_t min;
+  size_t max;
+  double median;
+  double sigma;
+  // the empirical histogram
+  int buckets;
+  size_t * bound;
+  double * cdf;
+} md_size_dist_t;
+
+// returns 0 on success, otherwise err contains the reason
+int md_size_dist_parse(md_size_dist_t * d, const char * spec, size_t fixed, char * err);
+void md_size_dist_free(md_size_dist_t * d);
+
+size_t md_size_dist_get(md_size_dist_t * d, int rank, int dset, int64_t obj);
+
+// the largest possible size and the mean size of a sample of objects
+size_t md_size_dist_max(md_size_dist_t * d);
+double md_size_dist_mean(md_size_dist_t * d);
+
+void md_size_dist_print(md_size_dist_t * d, char * buff);
+
+#endif
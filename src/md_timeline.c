@@ -0,0 +1,160 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <md_timeline.h>
+
+// the events of a process are appended to the file in chunks of this size
+#define CHUNK_SIZE (4 * 1024 * 1024)
+// the number of chunks, one is filled while the others are written
+#define CHUNKS 4
+// the maximum size of a single event
+#define MAX_EVENT 512
+
+struct md_timeline{
+  MPI_File fh;
+  MPI_Comm comm;
+  int rank;
+  timer start;
+  char * buf[CHUNKS];
+  size_t size[CHUNKS]; // the size of each handed over chunk
+  size_t used; // of the chunk that is filled
+  uint64_t head; // the chunks handed over to the writer thread, written by the producer
+  uint64_t tail; // the chunks written, written by the writer thread
+  int stop;
+  pthread_t thread;
+};
+
+static void write_chunk(md_timeline_t * t, char * buf, size_t size){
+  if(size > 0){
+    MPI_File_write_shared(t->fh, buf, (int) size, MPI_BYTE, MPI_STATUS_IGNORE);
+  }
+}
+
+// the only thread that writes the file between md_timeline_open() and md_timeline_close()
+static void * writer_main(void * arg){
+  md_timeline_t * t = (md_timeline_t *) arg;
+  while(1){
+    // all chunks have been handed over before stop is set, so they are seen by the following pass
+    const int stop = __atomic_load_n(& t->stop, __ATOMIC_ACQUIRE);
+    const uint64_t head = __atomic_load_n(& t->head, __ATOMIC_ACQUIRE);
+    for(uint64_t c = t->tail; c < head; c++){
+      write_chunk(t, t->buf[c % CHUNKS], t->size[c % CHUNKS]);
+      __atomic_store_n(& t->tail, c + 1, __ATOMIC_RELEASE);
+    }
+    if(head == t->tail){
+      if(stop){
+        break;
+      }
+      struct timespec wait = {0, 100 * 1000};
+      nanosleep(& wait, NULL);
+    }
+  }
+  return NULL;
+}
+
+// hand the filled chunk to the writer thread and continue with the next one
+static void hand_over_chunk(md_timeline_t * t){
+  if(t->used == 0){
+    return;
+  }
+  t->size[t->head % CHUNKS] = t->used;
+  __atomic_store_n(& t->head, t->head + 1, __ATOMIC_RELEASE);
+  t->used = 0;
+  // back-pressure: wait until the writer has written the next chunk, no event is dropped
+  while(t->head - __atomic_load_n(& t->tail, __ATOMIC_ACQUIRE) == CHUNKS){
+    sched_yield();
+  }
+}
+
+// every event is prefixed with the separator, the header written by rank 0 is the first element of the array
+static char * reserve_event(md_timeline_t * t){
+  if(t->used + MAX_EVENT > CHUNK_SIZE){
+    hand_over_chunk(t);
+  }
+  return t->buf[t->head % CHUNKS] + t->used;
+}
+
+md_timeline_t * md_timeline_open(const char * file, MPI_Comm comm){
+  md_timeline_t * t = malloc(sizeof(md_timeline_t));
+  memset(t, 0, sizeof(md_timeline_t));
+  t->comm = comm;
+  MPI_Comm_rank(comm, & t->rank);
+  int ret = MPI_File_open(comm, (char *) file, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, & t->fh);
+  if(ret != MPI_SUCCESS){
+    if(t->rank == 0){
+      printf("Error opening the trace-event file: %s\n", file);
+    }
+    free(t);
+    return NULL;
+  }
+  MPI_File_set_size(t->fh, 0);
+  for(int i=0; i < CHUNKS; i++){
+    t->buf[i] = malloc(CHUNK_SIZE);
+  }
+
+  // each process is a track named by its rank
+  const char * name_fmt = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"rank %d\"}}";
+  if(t->rank == 0){
+    t->used = sprintf(t->buf[0], "[\n");
+    t->used += sprintf(t->buf[0] + t->used, name_fmt, t->rank, t->rank);
+    write_chunk(t, t->buf[0], t->used);
+    t->used = 0;
+  }
+  MPI_Barrier(comm);
+  if(t->rank != 0){
+    t->used = sprintf(t->buf[0], ",\n");
+    t->used += sprintf(t->buf[0] + t->used, name_fmt, t->rank, t->rank);
+  }
+  MPI_Barrier(comm);
+  pthread_create(& t->thread, NULL, writer_main, t);
+  start_timer(& t->start);
+  return t;
+}
+
+void md_timeline_op(md_timeline_t * t, const char * name, timer start, double runtime, int obj_rank, int dset, int64_t obj, int ret){
+  char * e = reserve_event(t);
+  t->used += sprintf(e, ",\n{\"name\":\"%s\",\"cat\":\"op\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":0,\"args\":{\"obj_rank\":%d,\"dset\":%d,\"obj\":%lld,\"ret\":%d}}",
+    name, timer_subtract(start, t->start) * 1e6, runtime * 1e6, t->rank, obj_rank, dset, (long long) obj, ret);
+}
+
+void md_timeline_instant(md_timeline_t * t, const char * name){
+  char * e = reserve_event(t);
+  t->used += sprintf(e, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f,\"pid\":%d,\"tid\":0}", name, stop_timer(t->start) * 1e6, t->rank);
+}
+
+void md_timeline_close(md_timeline_t * t){
+  hand_over_chunk(t);
+  __atomic_store_n(& t->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(t->thread, NULL);
+  MPI_Barrier(t->comm);
+  if(t->rank == 0){
+    t->used = sprintf(t->buf[0], "\n]\n");
+    write_chunk(t, t->buf[0], t->used);
+  }
+  MPI_File_close(& t->fh);
+  for(int i=0; i < CHUNKS; i++){
+    free(t->buf[i]);
+  }
+  free(t);
+}
@@ -0,0 +1,49 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_TIMELINE_H
+#define MD_TIMELINE_H
+
+#include <stdint.h>
+
+#include <mpi.h>
+
+#include <md_util.h>
+
+/*
+ Export of the operations of all processes as trace-event JSON (Chrome tracing, Perfetto).
+ Each process is a track, the events are buffered in a few fixed-size chunks. A background thread appends
+ the full chunks to one shared file using the shared file pointer of MPI-IO, thus the memory is bounded
+ and no I/O is done while operations are timed; if all chunks are full, the next event waits for the writer.
+ The writer thread issues MPI calls, which needs MPI_THREAD_MULTIPLE.
+ The time stamps of all processes are relative to the synchronized md_timeline_open().
+*/
+typedef struct md_timeline md_timeline_t;
+
+// collective
+md_timeline_t * md_timeline_open(const char * file, MPI_Comm comm);
+
+// a completed operation that started at the timer
+void md_timeline_op(md_timeline_t * t, const char * name, timer start, double runtime, int obj_rank, int dset, int64_t obj, int ret);
+
+// an event at the current time, e.g., the start of a phase
+void md_timeline_instant(md_timeline_t * t, const char * name);
+
+// collective, writes all remaining events and completes the JSON
+void md_timeline_close(md_timeline_t * t);
+
+#endif
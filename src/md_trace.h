@@ -0,0 +1,62 @@
+// This file is part of MD-REAL-IO.
+//
+// MD-REAL-IO is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// MD-REAL-IO is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with MD-REAL-IO.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Author: Julian Kunkel
+
+#ifndef MD_TRACE_H
+#define MD_TRACE_H
+
+#include <stdint.h>
+
+/*
+ The binary trace of a phase, see --trace.
+ A trace file starts with the header followed by the records of all processes in rank order.
+ All values are stored in the byte order of the machine that wrote the trace, check the magic.
+*/
+
+#define MD_TRACE_MAGIC "MDWTRACE"
+#define MD_TRACE_VERSION 1
+#define MD_TRACE_HEADER_SIZE 512
+
+// the layout of a record as a string stored in the header
+#define MD_TRACE_FIELDS "start:u64,runtime:u64,obj:i64,rank:i32,obj_rank:i32,dset:i32,ret:i32,type:u8,reserved:u8[7]"
+// the names of the operation types, in the order of md_op_type
+#define MD_TRACE_TYPES "write,read,stat,delete"
+
+typedef struct{
+  uint64_t start;    // ns since the start of the phase
+  uint64_t runtime;  // ns
+  int64_t obj;       // the object index
+  int32_t rank;      // the process issuing the operation
+  int32_t obj_rank;  // the process the object belongs to
+  int32_t dset;      // the dataset number of the object
+  int32_t ret;       // the return code of the plugin
+  uint8_t type;      // md_op_type
+  uint8_t reserved[7];
+} md_trace_record_t;
+
+typedef struct{
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;  // the offset of the first record
+  uint32_t record_size;
+  uint32_t nprocs;
+  uint64_t record_count;
+  char phase[32];
+  char fields[256];  // MD_TRACE_FIELDS
+  char types[64];    // MD_TRACE_TYPES
+} md_trace_header_t;
+
+#endif
@@ -26,6 +26,50 @@
 
 #include <md_util.h>
 
+// the number of back-to-back readings to measure the overhead of the timer
+#define TIMER_SAMPLES 1001
+
+static double overhead_ns = 0;
+static double resolution_ns = 0;
+
+const char * md_timer_source_names[MD_TIMER_SOURCES] = {"monotonic", "monotonic-raw", "tsc"};
+
+int timer_source_parse(const char * name){
+  for(int i=0; i < MD_TIMER_SOURCES; i++){
+    if(strcmp(name, md_timer_source_names[i]) == 0){
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int compare_u64(const void * x, const void * y){
+  const uint64_t a = *(const uint64_t *) x;
+  const uint64_t b = *(const uint64_t *) y;
+  return a < b ? -1 : (a > b);
+}
+
+// the median of back-to-back readings
+static void measure_overhead(){
+  uint64_t samples[TIMER_SAMPLES];
+  for(int i=0; i < TIMER_SAMPLES; i++){
+    timer a, b;
+    start_timer(& a);
+    start_timer(& b);
+    samples[i] = timer_elapsed_ns(a, b);
+  }
+  qsort(samples, TIMER_SAMPLES, sizeof(uint64_t), compare_u64);
+  overhead_ns = (double) samples[TIMER_SAMPLES / 2];
+}
+
+double timer_overhead_ns(){
+  return overhead_ns;
+}
+
+double timer_resolution_ns(){
+  return resolution_ns;
+}
+
 #ifdef ESM
 void start_timer(timer * t1) {
     *t1 = clock64();
@@ -42,39 +86,149 @@ double timer_subtract(timer number, timer subtract){
   return (number - subtract) / 1000.0 / 1000.0;
 }
 
+void timer_add(timer * t, double seconds){
+  *t += (timer) (seconds * 1000.0 * 1000.0);
+}
+
+uint64_t timer_elapsed_ns(timer start, timer end){
+  return (uint64_t) (end - start) * 1000;
+}
+
+int timer_init(md_timer_source source){
+  if(source != MD_TIMER_MONOTONIC){
+    return -1;
+  }
+  resolution_ns = 1000;
+  measure_overhead();
+  return 0;
+}
+
+const char * timer_source_name(){
+  return "clock64";
+}
+
+uint64_t thread_cpu_ns(){
+  return 0;
+}
+
 #else // POSIX COMPLAINT
 
-void start_timer(timer * t1) {
-    clock_gettime(CLOCK_MONOTONIC, t1);
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+static md_timer_source source = MD_TIMER_MONOTONIC;
+static clockid_t clock_id = CLOCK_MONOTONIC;
+// the ticks of the TSC are converted with the fixed-point factor ns per tick * 2^32
+static uint64_t tsc_mult = 0;
+static double seconds_per_tick = 1e-9;
+
+static inline uint64_t clock_ns(clockid_t id){
+  struct timespec t;
+  clock_gettime(id, & t);
+  return (uint64_t) t.tv_sec * 1000000000ull + t.tv_nsec;
 }
 
-static timer time_diff (struct timespec end, struct timespec start) {
-    struct timespec diff;
-    if (end.tv_nsec < start.tv_nsec) {
-        diff.tv_sec = end.tv_sec - start.tv_sec - 1;
-        diff.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
-    } else {
-        diff.tv_sec = end.tv_sec - start.tv_sec;
-        diff.tv_nsec = end.tv_nsec - start.tv_nsec;
-    }
-    return diff;
+void start_timer(timer * t1) {
+#ifdef HAVE_TSC
+  if(source == MD_TIMER_TSC){
+    unsigned aux;
+    *t1 = __rdtscp(& aux);
+    return;
+  }
+#endif
+  *t1 = clock_ns(clock_id);
 }
 
-static double time_to_double (struct timespec t) {
-    double d = (double)t.tv_nsec;
-    d /= 1000000000.0;
-    d += (double)t.tv_sec;
-    return d;
+uint64_t timer_elapsed_ns(timer start, timer end){
+  const uint64_t ticks = end - start;
+  if(tsc_mult == 0){
+    return ticks;
+  }
+  return (ticks >> 32) * tsc_mult + (((ticks & 0xffffffffull) * tsc_mult) >> 32);
 }
 
 double timer_subtract(timer number, timer subtract){
-  return time_to_double(time_diff(number, subtract));
+  return (double) (int64_t) (number - subtract) * seconds_per_tick;
 }
 
 double stop_timer(timer t1) {
     timer end;
     start_timer(& end);
-    return time_to_double(time_diff(end, t1));
+    return timer_subtract(end, t1);
+}
+
+void timer_add(timer * t, double seconds){
+    *t += (int64_t) (seconds / seconds_per_tick);
+}
+
+#ifdef HAVE_TSC
+// calibrate the invariant TSC against CLOCK_MONOTONIC_RAW, returns 0 on success
+static int calibrate_tsc(){
+  unsigned eax, ebx, ecx, edx;
+  if(! __get_cpuid(0x80000007, & eax, & ebx, & ecx, & edx) || ! (edx & (1 << 8))){
+    return -1;
+  }
+  unsigned aux;
+  const uint64_t ns_start = clock_ns(CLOCK_MONOTONIC_RAW);
+  const uint64_t tsc_start = __rdtscp(& aux);
+  uint64_t ns_end;
+  do{
+    ns_end = clock_ns(CLOCK_MONOTONIC_RAW);
+  }while(ns_end - ns_start < 50000000ull);
+  const uint64_t tsc_end = __rdtscp(& aux);
+  const double ticks_per_ns = (double) (tsc_end - tsc_start) / (ns_end - ns_start);
+  tsc_mult = (uint64_t) (4294967296.0 / ticks_per_ns + 0.5);
+  seconds_per_tick = 1e-9 / ticks_per_ns;
+  resolution_ns = 1 / ticks_per_ns;
+  return 0;
 }
+#endif
 
+int timer_init(md_timer_source new_source){
+  struct timespec res;
+  switch(new_source){
+    case(MD_TIMER_MONOTONIC):
+    case(MD_TIMER_MONOTONIC_RAW):
+      clock_id = new_source == MD_TIMER_MONOTONIC ? CLOCK_MONOTONIC : CLOCK_MONOTONIC_RAW;
+      clock_getres(clock_id, & res);
+      resolution_ns = res.tv_sec * 1e9 + res.tv_nsec;
+      tsc_mult = 0;
+      seconds_per_tick = 1e-9;
+      break;
+    case(MD_TIMER_TSC):
+#ifdef HAVE_TSC
+      if(calibrate_tsc() != 0){
+        return -1;
+      }
+      break;
+#else
+      return -1;
 #endif
+    default:
+      return -1;
+  }
+  source = new_source;
+  measure_overhead();
+  return 0;
+}
+
+const char * timer_source_name(){
+  return md_timer_source_names[source];
+}
+
+uint64_t thread_cpu_ns(){
+  return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+#endif
+
+uint64_t mix64(uint64_t x){
+  // splitmix64
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
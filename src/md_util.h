@@ -18,23 +18,68 @@
 #ifndef MD_UTIL_H
 #define MD_UTIL_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <time.h>
 
-// timer functions
+// timer functions, a timer holds integer ticks of the selected source
 #ifdef ESM
 typedef clock64_t timer;
 #else
-typedef struct timespec timer;
+typedef uint64_t timer;
 #endif
 
+typedef enum{
+  MD_TIMER_MONOTONIC,
+  MD_TIMER_MONOTONIC_RAW,
+  MD_TIMER_TSC, // the invariant time stamp counter calibrated against CLOCK_MONOTONIC_RAW
+  MD_TIMER_SOURCES
+} md_timer_source;
+
+extern const char * md_timer_source_names[MD_TIMER_SOURCES];
+
+// the source of the name, -1 for an unknown name
+int timer_source_parse(const char * name);
+
+// select the source for all timers and measure its overhead, returns 0 on success
+// must be called before any timer is started, the default is MD_TIMER_MONOTONIC
+int timer_init(md_timer_source source);
+const char * timer_source_name();
+// the median cost of reading the timer and its resolution
+double timer_overhead_ns();
+double timer_resolution_ns();
+
 void start_timer(timer * t1);
 double stop_timer(timer t1);
 double timer_subtract(timer number, timer subtract);
+// the nanoseconds between two timers, computed with integer arithmetic
+uint64_t timer_elapsed_ns(timer start, timer end);
+// advance the timer by the given seconds
+void timer_add(timer * t, double seconds);
+// the CPU time consumed by the calling thread
+uint64_t thread_cpu_ns();
 
+// the splitmix64 finalizer, a deterministic hash used to derive random choices from indices
+uint64_t mix64(uint64_t x);
 
-// allow to allocate memory
-int mem_preallocate(char ** allocP, uint64_t maxRAMinMB, int verbose);
+
+// allow to allocate memory until the free memory is below the limit in MiB
+int mem_preallocate(char ** allocP, uint64_t maxRAMinMiB, int verbose);
 void mem_free_preallocated(char ** allocP);
 
+// allocate memory that is faulted in before use, optionally on huge pages and locked into RAM
+// the size is updated to the size of the mapping, which is needed to free it
+void * mem_arena_alloc(size_t * size, int hugepages, int lock, int verbose);
+void mem_arena_free(void * p, size_t size);
+
+/*
+ A thread that keeps the memory usable for caching (free memory and page cache, limited by the memory.max
+ of a cgroup v2) at the target by growing and shrinking a populated and locked mapping. Thus, the page cache
+ cannot grow beyond the target during the phases. The log file receives the achieved values over time.
+*/
+typedef struct mem_balloon mem_balloon_t;
+
+mem_balloon_t * mem_balloon_start(uint64_t target_mib, double interval, int lock, const char * log_file);
+void mem_balloon_stop(mem_balloon_t * b, int verbose);
+
 #endif
@@ -17,8 +17,10 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -63,15 +65,15 @@ static uint64_t getFreeRamKB(){
 	return getValue("\nMemFree:") +getValue("\nCached:") + getValue("\nBuffers:");
 }
 
-int mem_preallocate(char ** allocP, uint64_t maxRAMinMB, int verbose){
-  if(maxRAMinMB == 0){
+int mem_preallocate(char ** allocP, uint64_t maxRAMinMiB, int verbose){
+  if(maxRAMinMiB == 0){
     return 0;
   }
 	uint64_t currentRAMinKB = getFreeRamKB();
   const uint32_t pagesize = getpagesize();
 
   assert(*allocP == NULL);
-  const uint64_t maxRAMinKB = 1000 * maxRAMinMB;
+  const uint64_t maxRAMinKB = 1024 * maxRAMinMiB;
 
   if(verbose){
 	 printf ("starting to malloc RAM currently \n %lu KiB => goal %lu KiB\n", (uint64_t) currentRAMinKB, (uint64_t) maxRAMinKB);
@@ -113,3 +115,244 @@ void mem_free_preallocated(char ** allocP){
   free(*allocP);
   *allocP = NULL;
 }
+
+void * mem_arena_alloc(size_t * size_p, int hugepages, int lock, int verbose){
+  size_t size = *size_p;
+  if(size == 0){
+    return NULL;
+  }
+  void * p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if(hugepages){
+    // explicit huge pages must be reserved by the administrator, otherwise try transparent huge pages
+    const size_t huge_size = 2 * 1024 * 1024;
+    const size_t huge_total = (size + huge_size - 1) / huge_size * huge_size;
+    p = mmap(NULL, huge_total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p != MAP_FAILED){
+      size = huge_total;
+    }else if(verbose){
+      printf("No reserved huge pages available, using transparent huge pages\n");
+    }
+  }
+#endif
+  if(p == MAP_FAILED){
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED){
+      return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if(hugepages){
+      madvise(p, size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  // prefault all pages
+  const size_t pagesize = getpagesize();
+  for(size_t pos = 0; pos < size; pos += pagesize){
+    ((volatile char *) p)[pos] = 0;
+  }
+  if(lock && mlock(p, size) != 0){
+    printf("Warning: could not lock %zu bytes of memory, check ulimit -l\n", size);
+  }
+  *size_p = size;
+  return p;
+}
+
+void mem_arena_free(void * p, size_t size){
+  if(p != NULL){
+    munmap(p, size);
+  }
+}
+
+// the balloon grows and shrinks in chunks of this size
+#define BALLOON_CHUNK (4 * 1024 * 1024)
+// the maximum growth per adjustment to let the page cache shrink gradually
+#define BALLOON_MAX_GROW (64 * BALLOON_CHUNK)
+
+struct mem_balloon{
+  pthread_t thread;
+  int stop;
+  uint64_t target_kb;
+  double interval;
+  int lock;
+  char cgroup[1024]; // the directory of the cgroup v2 with a memory limit, empty otherwise
+
+  void ** chunks;
+  size_t chunk_count;
+  size_t chunk_capacity;
+
+  FILE * log;
+  timer start;
+  // statistics of the cacheable memory
+  uint64_t samples;
+  double free_sum;
+  uint64_t free_min;
+  uint64_t free_max;
+  size_t chunks_max;
+};
+
+static int read_cgroup_value(const char * dir, const char * file, const char * key, uint64_t * out){
+  char name[2048];
+  char buff[4096];
+  sprintf(name, "%s/%s", dir, file);
+  FILE * f = fopen(name, "r");
+  if(f == NULL){
+    return -1;
+  }
+  int ret = -1;
+  const size_t key_len = key ? strlen(key) : 0;
+  while(fgets(buff, sizeof(buff), f)){
+    if(key == NULL || (strncmp(buff, key, key_len) == 0 && buff[key_len] == ' ')){
+      char * end;
+      *out = strtoull(buff + key_len, & end, 10);
+      ret = end == buff + key_len ? -1 : 0; // e.g. "max" for an unlimited cgroup
+      break;
+    }
+  }
+  fclose(f);
+  return ret;
+}
+
+// find the cgroup v2 of this process if it has a memory limit
+static void find_cgroup(mem_balloon_t * b){
+  b->cgroup[0] = 0;
+  FILE * f = fopen("/proc/self/cgroup", "r");
+  if(f == NULL){
+    return;
+  }
+  char line[1024];
+  char path[1024] = "";
+  while(fgets(line, sizeof(line), f)){
+    if(strncmp(line, "0::", 3) == 0){
+      strncpy(path, line + 3, sizeof(path) - 1);
+      path[strcspn(path, "\n")] = 0;
+    }
+  }
+  fclose(f);
+  const char * mounts[] = {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"};
+  for(int i=0; i < 2; i++){
+    char dir[1024];
+    uint64_t max;
+    snprintf(dir, sizeof(dir), "%s%s", mounts[i], path);
+    if(read_cgroup_value(dir, "memory.max", NULL, & max) == 0){
+      strcpy(b->cgroup, dir);
+      return;
+    }
+  }
+}
+
+// the memory in KiB usable for caching: free memory and the page cache, limited by the cgroup
+static uint64_t get_cacheable_kb(mem_balloon_t * b){
+  uint64_t kb = getFreeRamKB();
+  uint64_t max, current, file;
+  if(b->cgroup[0] && read_cgroup_value(b->cgroup, "memory.max", NULL, & max) == 0 && read_cgroup_value(b->cgroup, "memory.current", NULL, & current) == 0 && read_cgroup_value(b->cgroup, "memory.stat", "file", & file) == 0){
+    const uint64_t cg_kb = (max > current ? max - current : 0) / 1024 + file / 1024;
+    kb = cg_kb < kb ? cg_kb : kb;
+  }
+  return kb;
+}
+
+static int balloon_grow(mem_balloon_t * b){
+  void * p = mmap(NULL, BALLOON_CHUNK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if(p == MAP_FAILED){
+    return -1;
+  }
+  if(b->lock && mlock(p, BALLOON_CHUNK) != 0){
+    printf("Warning: could not lock the memory of the balloon, check ulimit -l\n");
+    b->lock = 0;
+  }
+  if(b->chunk_count == b->chunk_capacity){
+    b->chunk_capacity = b->chunk_capacity == 0 ? 256 : b->chunk_capacity * 2;
+    b->chunks = realloc(b->chunks, sizeof(void *) * b->chunk_capacity);
+  }
+  b->chunks[b->chunk_count++] = p;
+  if(b->chunk_count > b->chunks_max){
+    b->chunks_max = b->chunk_count;
+  }
+  return 0;
+}
+
+static void balloon_shrink(mem_balloon_t * b){
+  munmap(b->chunks[--b->chunk_count], BALLOON_CHUNK);
+}
+
+// bring the cacheable memory to the target, growing is limited to let the kernel reclaim the cache
+static void balloon_adjust(mem_balloon_t * b){
+  const uint64_t chunk_kb = BALLOON_CHUNK / 1024;
+  uint64_t free_kb = get_cacheable_kb(b);
+  if(free_kb < b->target_kb){
+    while(free_kb < b->target_kb && b->chunk_count > 0){
+      balloon_shrink(b);
+      free_kb += chunk_kb;
+    }
+  }else{
+    for(int i=0; free_kb >= b->target_kb + chunk_kb && i < BALLOON_MAX_GROW / BALLOON_CHUNK; i++){
+      if(balloon_grow(b) != 0){
+        break;
+      }
+      free_kb -= chunk_kb;
+    }
+  }
+  free_kb = get_cacheable_kb(b);
+  b->samples++;
+  b->free_sum += free_kb;
+  b->free_min = b->samples == 1 || free_kb < b->free_min ? free_kb : b->free_min;
+  b->free_max = free_kb > b->free_max ? free_kb : b->free_max;
+  if(b->log){
+    fprintf(b->log, "%.3f,%.1f,%.1f\n", stop_timer(b->start), free_kb / 1024.0, b->chunk_count * (double) chunk_kb / 1024.0);
+  }
+}
+
+static void * balloon_main(void * arg){
+  mem_balloon_t * b = (mem_balloon_t *) arg;
+  struct timespec wait = {(time_t) b->interval, (long) ((b->interval - (time_t) b->interval) * 1e9)};
+  while(! __atomic_load_n(& b->stop, __ATOMIC_ACQUIRE)){
+    nanosleep(& wait, NULL);
+    balloon_adjust(b);
+  }
+  return NULL;
+}
+
+mem_balloon_t * mem_balloon_start(uint64_t target_mib, double interval, int lock, const char * log_file){
+  mem_balloon_t * b = malloc(sizeof(mem_balloon_t));
+  memset(b, 0, sizeof(mem_balloon_t));
+  b->target_kb = target_mib * 1024;
+  b->interval = interval;
+  b->lock = lock;
+  find_cgroup(b);
+  if(log_file){
+    b->log = fopen(log_file, "w");
+    if(b->log == NULL){
+      printf("Error writing the balloon log: %s\n", log_file);
+    }else{
+      fprintf(b->log, "time,free_mib,balloon_mib\n");
+    }
+  }
+  start_timer(& b->start);
+  // reach the target before the benchmark starts
+  size_t count;
+  do{
+    count = b->chunk_count;
+    balloon_adjust(b);
+  }while(b->chunk_count - count == BALLOON_MAX_GROW / BALLOON_CHUNK);
+  pthread_create(& b->thread, NULL, balloon_main, b);
+  return b;
+}
+
+void mem_balloon_stop(mem_balloon_t * b, int verbose){
+  __atomic_store_n(& b->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(b->thread, NULL);
+  if(verbose){
+    printf("Balloon: target %.0f MiB cacheable memory (min:%.0f mean:%.0f max:%.0f MiB) balloon max:%.0f MiB%s%s\n",
+      b->target_kb / 1024.0, b->free_min / 1024.0, b->free_sum / b->samples / 1024.0, b->free_max / 1024.0,
+      b->chunks_max * (double) BALLOON_CHUNK / 1024 / 1024, b->cgroup[0] ? " cgroup:" : "", b->cgroup);
+  }
+  while(b->chunk_count > 0){
+    balloon_shrink(b);
+  }
+  if(b->log){
+    fclose(b->log);
+  }
+  free(b->chunks);
+  free(b);
+}
@@ -0,0 +1,124 @@
+#!/bin/bash -e
+
+# This benchmark measures the overhead of the harness itself, i.e., the time md-workbench adds to each
+# operation of a backend. As this overhead cannot be distinguished from the latency of a fast backend,
+# changes to md-workbench.c must not increase it silently.
+#
+# For each configuration it derives:
+#  timer_ns       the median latency reported for the null backend, i.e., the cost of the timer
+#  stats_ns       the remaining time per operation of the benchmark phase with the null backend: loop and statistics recording
+#  name_ns        the additional time per object of the precreate phase with the names of the dummy backend
+#  aggregation_ms the time of the end-of-phase aggregation of the benchmark phase
+#
+# Synopsis: harness-overhead.sh <md-workbench> <baseline.csv> [--update]
+# With --update, the baseline is (re)written from the maximum of ROUNDS rounds, i.e., the noise of the machine.
+# Without a baseline, or if it lacks a measured configuration, the test is skipped with exit code 77.
+# The baseline is only valid for the machine it was recorded on, thus it is kept in the build tree.
+# Configurations with more processes than cores are not measured, they only measure the scheduler.
+# Environment: TOLERANCE (relative, default 0.5), REPEATS (default 3), ROUNDS (default 5), MPI_ARGS
+
+BIN="$1"
+BASELINE="$2"
+UPDATE="$3"
+TOLERANCE=${TOLERANCE:-0.5}
+REPEATS=${REPEATS:-3}
+ROUNDS=${ROUNDS:-5}
+
+if [[ -z "$BIN" || -z "$BASELINE" ]] ; then
+  echo "Synopsis: $0 <md-workbench> <baseline.csv> [--update]"
+  exit 1
+fi
+
+TMP=$(mktemp -d)
+trap "rm -rf $TMP" EXIT
+
+# run the configuration REPEATS times and print the minimum of each value:
+# "<precreate ns/op> <benchmark ns/op> <benchmark median latency ns> <benchmark aggregation ms>"
+function measure(){
+  local np=$1
+  local plugin=$2
+  shift 2
+  for r in $(seq $REPEATS) ; do
+    mpiexec -n $np $MPI_ARGS $BIN -i=$plugin -v -D=1 -R=1 "$@" > $TMP/out
+    # the rate of all processes and the maximum time are reported, the time per operation of a process is derived
+    awk -v np=$np '
+      $2 == "process" {
+        match($0, /rate:[0-9.]+ iops/); rate[$1] = substr($0, RSTART + 5, RLENGTH - 10)
+        match($0, /[a-z]+\([^)]*\)/); split(substr($0, RSTART, RLENGTH), q, /[(,]/)
+        median[$1] = q[4]
+      }
+      $2 ~ /^aggregation:/ { agg[$1] = substr($2, 13) }
+      END { printf("%.1f %.1f %.1f %.3f\n", 1e9 * np / rate["precreate"], 1e9 * np / rate["benchmark"], median["benchmark"] * 1e9, agg["benchmark"] * 1000) }' $TMP/out
+  done | awk '{ for(i=1; i <= NF; i++) if(NR == 1 || $i < m[i]) m[i] = $i } END { print m[1], m[2], m[3], m[4] }'
+}
+
+if [[ "$UPDATE" != "--update" && ! -e "$BASELINE" ]] ; then
+  echo "No baseline $BASELINE, run with --update to create it"
+  exit 77
+fi
+
+NPS=1
+if [[ $(nproc) -ge 2 ]] ; then
+  NPS="1 2"
+fi
+
+# print one CSV line per configuration
+function measure_all(){
+  for np in $NPS ; do
+    for objects in 2000 20000 ; do
+      for latency in none all ; do
+        ARGS="-P=$objects -I=$objects"
+        if [[ $latency == all ]] ; then
+          ARGS="$ARGS -L=$TMP/lat --latency-all"
+        fi
+        read null_ns bench_ns timer_ns aggregation_ms < <(measure $np null $ARGS)
+        read dummy_ns x < <(measure $np dummy $ARGS)
+        awk -v c="np=$np/objects=$objects/latency=$latency" 'BEGIN{ printf("%s,%.1f,%.1f,%.1f,%.3f\n", c, '$timer_ns', '$bench_ns' - '$timer_ns', '$dummy_ns' - '$null_ns', '$aggregation_ms') }'
+      done
+    done
+  done
+}
+
+if [[ "$UPDATE" == "--update" ]] ; then
+  for r in $(seq $ROUNDS) ; do
+    measure_all
+  done > $TMP/rounds.csv
+  echo "config,timer_ns,stats_ns,name_ns,aggregation_ms" > $TMP/result.csv
+  # the maximum of each metric over the rounds in the order of the configurations
+  awk -F, -v OFS=, '
+    ! ($1 in m) { order[n++] = $1; m[$1] = 1 }
+    { for(i=2; i <= NF; i++) if(! (($1, i) in v) || $i > v[$1, i]) v[$1, i] = $i }
+    END { for(c=0; c < n; c++){ k = order[c]; print k, v[k, 2], v[k, 3], v[k, 4], v[k, 5] } }' $TMP/rounds.csv >> $TMP/result.csv
+  cat $TMP/result.csv
+  cp $TMP/result.csv "$BASELINE"
+  echo "Updated the baseline $BASELINE"
+  exit 0
+fi
+
+echo "config,timer_ns,stats_ns,name_ns,aggregation_ms" > $TMP/result.csv
+measure_all >> $TMP/result.csv
+cat $TMP/result.csv
+
+# a metric regresses if it exceeds the baseline by the tolerance, small absolute values are noise
+awk -F, -v tolerance=$TOLERANCE '
+  FNR == 1 { split($0, names, ","); next }
+  NR == FNR { for(i=2; i <= NF; i++) base[$1, i] = $i; next }
+  ! (($1, 2) in base) { printf("No baseline for %s\n", $1); missing = 1; next }
+  {
+    for(i=2; i <= NF; i++){
+      slack = (i == 5) ? 1 : 10
+      if($i > base[$1, i] * (1 + tolerance) + slack){
+        printf("REGRESSION %s %s: %s (baseline %s)\n", $1, names[i], $i, base[$1, i])
+        failed = 1
+      }
+    }
+  }
+  END { exit failed ? 1 : (missing ? 77 : 0) }' "$BASELINE" $TMP/result.csv || ret=$?
+if [[ ${ret:-0} == 77 ]] ; then
+  echo "The baseline $BASELINE is incomplete, run with --update to recreate it"
+  exit 77
+fi
+if [[ ${ret:-0} != 0 ]] ; then
+  exit $ret
+fi
+echo "No regression compared to $BASELINE"